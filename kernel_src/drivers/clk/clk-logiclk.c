@@ -14,11 +14,30 @@
  * GNU General Public License for more details.
  */
 
+#include <linux/clk.h>
 #include <linux/clk-provider.h>
+#include <linux/clk/logiclk.h>
+#include <linux/completion.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
+#include <linux/interrupt.h>
+#include <linux/ktime.h>
+#include <linux/list.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/of.h>
+#include <linux/of_address.h>
+#include <linux/of_device.h>
+#include <linux/of_irq.h>
 #include <linux/platform_device.h>
+#include <linux/pm_runtime.h>
+#include <linux/regmap.h>
+#include <linux/reset.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/uaccess.h>
+#include <linux/workqueue.h>
 
 /* logiCLK registers */
 #define LOGICLK_REG_STRIDE		4
@@ -27,45 +46,103 @@
 
 #define LOGICLK_MANUAL_REGS		21
 
+#define LOGICLK_PLL_REG			(LOGICLK_PLL_REG_OFF * LOGICLK_REG_STRIDE)
+#define LOGICLK_MAN_REG(i)		\
+	(((i) + LOGICLK_PLL_MAN_REG_OFF) * LOGICLK_REG_STRIDE)
+
+/* CLKOUT0 fractional bits in CLKOUT5 second register */
+#define LOGICLK_CLKOUT5_REG2		12
+#define LOGICLK_CLKOUT0_FRAC_SHIFT	10
+#define LOGICLK_CLKOUT0_FRAC_MASK	(0xF << LOGICLK_CLKOUT0_FRAC_SHIFT)
+
 /* logiCLK PLL bits */
 #define LOGICLK_PLL_LOCK		BIT(0)
 #define LOGICLK_PLL_CONFIG		BIT(0)
 #define LOGICLK_PLL_CONFIG_SW		BIT(1)
 
-/* logiCLK parameters for 7 series */
-#define MMCM_INPUT_FREQ_MIN		10000000UL
-#define MMCM_INPUT_FREQ_MAX		800000000UL
-#define MMCM_OUTPUT_FREQ_MIN		4690000UL
-#define MMCM_OUTPUT_FREQ_MAX		800000000UL
-#define MMCM_VCO_FREQ_MIN		600000000ULL
-#define MMCM_VCO_FREQ_MAX		1600000000ULL
-
+/* MMCM counter parameters common to all device families */
 #define MMCM_PHASE_MIN			-360000L
 #define MMCM_PHASE_MAX			360000L
 
 #define MMCM_CLKOUT_DIVIDE_MIN		1
 #define MMCM_CLKOUT_DIVIDE_MAX		128
+#define MMCM_CLKOUT_DIVIDE_F_MIN	2
+#define MMCM_CLKOUT_FRAC_STEPS		8
 #define MMCM_CLKOUT_DUTY_MIN		100
 #define MMCM_CLKOUT_DUTY_MAX		99900
 #define MMCM_CLKOUT_PHASE_MIN		MMCM_PHASE_MIN
 #define MMCM_CLKOUT_PHASE_MAX		MMCM_PHASE_MAX
-#define MMCM_DIVCLK_DIVIDE_MIN		1
-#define MMCM_DIVCLK_DIVIDE_MAX		56
 #define MMCM_FBOUT_PHASE_MIN		MMCM_PHASE_MIN
 #define MMCM_FBOUT_PHASE_MAX		MMCM_PHASE_MAX
-#define MMCM_FBOUT_MULTIPLY_MIN		2
-#define MMCM_FBOUT_MULTIPLY_MAX		64
+
+#define MMCM_LUT_SIZE			64
 
 #define LOGICLK_FRACTION_PRECISION	10
-#define LOGICLK_OUTPUTS			6
+#define LOGICLK_OUTPUTS_MIN		2
+
+#define PLL_LOCK_SLEEP_US		100
+#define PLL_LOCK_TIMEOUT_US		50000
+#define PLL_UNLOCK_TIMEOUT_US		1000
+#define PLL_LOCK_POLL_MS		1000
+
+#define LOGICLK_SOLVER_DEFAULT		"pruned"
+/* covers every input multiplier and divider pair, bounds exhaustive search */
+#define LOGICLK_SOLVER_BUDGET_DEFAULT	4096
+#define LOGICLK_TOLERANCE_MAX		1000000
+#define LOGICLK_CANDIDATES_DEFAULT	4
+#define LOGICLK_CANDIDATES_MAX		16
+
+static char *solver_name;
+module_param_named(solver, solver_name, charp, S_IRUGO);
+MODULE_PARM_DESC(solver,
+		 "Default solver (exhaustive, pruned, table, incremental)");
+
+static unsigned int solver_budget = LOGICLK_SOLVER_BUDGET_DEFAULT;
+module_param(solver_budget, uint, S_IRUGO);
+MODULE_PARM_DESC(solver_budget,
+		 "Default solver iterations budget (0 = unlimited, default 4096)");
 
-#define PLL_LOCK_TIME_MS		1
-#define PLL_LOCK_TIME_INTERVALS		50
+/**
+ * struct logiclk_limits:
+ * @input_freq_min:	Minimum input clock frequency
+ * @input_freq_max:	Maximum input clock frequency
+ * @output_freq_min:	Minimum output clock frequency
+ * @output_freq_max:	Maximum output clock frequency
+ * @vco_freq_min:	Minimum VCO frequency
+ * @vco_freq_max:	Maximum VCO frequency
+ * @divclk_divide_min:	Minimum input clock divider
+ * @divclk_divide_max:	Maximum input clock divider
+ * @fbout_multiply_min:	Minimum input clock multiplier
+ * @fbout_multiply_max:	Maximum input clock multiplier
+ */
+struct logiclk_limits {
+	u32 input_freq_min;
+	u32 input_freq_max;
+	u32 output_freq_min;
+	u32 output_freq_max;
+	u64 vco_freq_min;
+	u64 vco_freq_max;
+	u32 divclk_divide_min;
+	u32 divclk_divide_max;
+	u32 fbout_multiply_min;
+	u32 fbout_multiply_max;
+};
 
-#define LOGICLK_CONFIG_SW		true
-#define LOGICLK_CONFIG_HW		false
-#define LOGICLK_STACK_PUSH		true
-#define LOGICLK_STACK_POP		false
+/**
+ * struct logiclk_family:
+ * @limits:		Device family MMCM limits
+ * @lut_filter_high:	High bandwidth filter lookup table
+ * @lut_filter_low:	Low bandwidth filter lookup table
+ * @lut_lock:		Lock lookup table
+ *
+ * Lookup tables are indexed with input clock multiplier.
+ */
+struct logiclk_family {
+	struct logiclk_limits limits;
+	const u32 *lut_filter_high;
+	const u32 *lut_filter_low;
+	const u64 *lut_lock;
+};
 
 /**
  * struct logiclk_input:
@@ -89,9 +166,11 @@ struct logiclk_input {
  * @data:		Pointer to parent structure
  * @clkout_freq:	Output clock frequency
  * @clkout_divide:	Output clock divider
+ * @clkout_frac:	Output clock divider fraction in 1/8 steps
  * @clkout_duty:	Output clock duty cycle
  * @clkout_phase:	Output clock phase
  * @precise:		Flag for precision clock
+ * @rate_set:		Frequency set by consumer before device attach
  * @id:			Output ID
  */
 struct logiclk_output {
@@ -100,59 +179,496 @@ struct logiclk_output {
 	struct logiclk_data *data;
 	u32 clkout_freq;
 	u32 clkout_divide;
+	u32 clkout_frac;
 	u32 clkout_duty;
 	u32 clkout_phase;
 	u8 id;
 	bool precise;
+	bool rate_set;
+};
+
+/**
+ * struct logiclk_solution:
+ * @clkfbout_mult:	Input clock multiplier
+ * @divclk_divide:	Input clock divider
+ * @freq_err:		Precise output frequency error
+ * @iterations:		Number of evaluated configurations
+ * @budget:		Maximum number of evaluated configurations,
+ *			0 if unlimited
+ * @exhausted:		Search stopped on budget before completing
+ * @frac:		Fractional output divider allowed
+ */
+struct logiclk_solution {
+	u32 clkfbout_mult;
+	u32 divclk_divide;
+	u64 freq_err;
+	u32 iterations;
+	u32 budget;
+	bool exhausted;
+	bool frac;
+};
+
+/**
+ * struct logiclk_pending:
+ * @vco_freq:		VCO frequency of solved configuration, 0 if none
+ * @clk_freq:		Input clock frequency of solved configuration
+ * @clkfbout_mult:	Input clock multiplier
+ * @divclk_divide:	Input clock divider
+ * @clkout_freq:	Requested precise output frequency
+ */
+struct logiclk_pending {
+	u64 vco_freq;
+	u32 clk_freq;
+	u32 clkfbout_mult;
+	u32 divclk_divide;
+	u32 clkout_freq;
+};
+
+/**
+ * struct logiclk_state:
+ * @input:		Input clock configuration parameters
+ * @clkout_freq:	Output clock frequencies
+ * @clkout_divide:	Output clock dividers
+ * @clkout_frac:	Output clock divider fractions
+ * @valid:		State is saved
+ */
+struct logiclk_state {
+	struct logiclk_input input;
+	u32 clkout_freq[LOGICLK_OUTPUTS_MAX];
+	u32 clkout_divide[LOGICLK_OUTPUTS_MAX];
+	u32 clkout_frac[LOGICLK_OUTPUTS_MAX];
+	bool valid;
+};
+
+struct logiclk_data;
+
+/**
+ * struct logiclk_solver:
+ * @name:		Solver name
+ * @solve:		Search input multiplier and divider for output frequency
+ */
+struct logiclk_solver {
+	const char *name;
+	int (*solve)(struct logiclk_data *data, u64 freq_out,
+		     struct logiclk_solution *sol);
 };
 
 /**
  * struct logiclk_data:
  * @input:		Input clock configuration parameters
  * @output:		Output clock configuration parameters
- * @output_stack:	Output clock configuration parameters stack
- * @pdev:		Platform device
+ * @outputs:		Number of output clocks
+ * @precise:		Precise output clock
+ * @vco_hw:		VCO clock hw, parent of all output clocks
+ * @pending:		Precise output configuration waiting for VCO change
+ * @clk_in:		Input clock, NULL if input frequency is given in DT
+ * @input_nb:		Input clock rate change notifier
+ * @dev:		Device, NULL for early registered clocks without driver
+ * @dn:			Device node
+ * @early:		Clocks registered by early init
+ * @onecell:		Single clock provider data, NULL for per output
+ *			providers
  * @base:		Registers base
- * @man_regs:		Manual registers
- * @man_regs_stack:	Manual registers stack
+ * @regmap:		Registers map, caching manual registers written to hw
+ * @family:		Device family parameters
+ * @limits:		MMCM limits used by solver
+ * @solver:		Input multiplier and divider solver
+ * @solver_table:	Input multiplier and divider pairs for table solver
+ * @solver_table_len:	Number of pairs in solver table
+ * @solver_budget:	Solver iterations budget, 0 if unlimited
+ * @frac_divide:	Fractional divider used for first output
+ * @tolerance:		Precise output frequency tolerance in ppm for keeping
+ *			current input multiplier and divider
+ * @vco_pinned:		Current input multiplier and divider are never changed
+ * @regs:		Active and staged manual registers
+ * @man_regs:		Staged manual registers, filled by solving and
+ *			encoding without touching hw
+ * @cfg_lock:		Configuration parameters and staged registers lock,
+ *			held by rate changes, commits and their readers
+ * @list:		Entry in logiCLK devices list
+ * @debugfs:		Debugfs directory
+ * @dbg_output:		Debugfs candidates request output
+ * @dbg_rate:		Debugfs candidates request frequency, 0 if none
+ * @dbg_num:		Debugfs candidates request number
+ * @config_work:	Initial hw configuration work
+ * @configured:		Initial hw configuration done
+ * @config_err:		Initial hw configuration result, cleared by later
+ *			successful commit
+ * @deferred:		Initial hw configuration is committed on first output
+ *			prepare or rate change
+ * @hw_lock:		Hw programming lock
+ * @hw_regs:		Active manual registers, last committed
+ * @hw_regs_num:	Number of committed manual registers, 0 if hw
+ *			configuration is used
+ * @irq:		Lock status interrupt, 0 if lock is polled
+ * @locked:		Lock signaled by lock status interrupt
+ * @lock_monitor:	Lock polling work
+ * @lock_lost:		Number of lock losses
+ * @lock_time:		Last relock time in us, from configuration command
+ * @committed:		Configuration of last successful commit
+ * @commit_failed:	Number of commits rolled back on lock failure
+ * @commits:		Number of commits, tells initial configuration work
+ *			whether a rate change committed over it
+ * @prepared:		Number of prepared output clocks
+ * @monitored:		Lock monitor is running
+ * @pwrdn:		MMCM power-down control, NULL if MMCM always runs
+ * @powered_down:	MMCM is powered down, commits only update cached
+ *			registers
  */
 struct logiclk_data {
 	struct logiclk_input input;
-	struct logiclk_output output[LOGICLK_OUTPUTS];
-	struct logiclk_output output_stack;
-	struct platform_device *pdev;
+	struct logiclk_output *output;
+	int outputs;
+	struct logiclk_output *precise;
+	struct clk_hw vco_hw;
+	struct logiclk_pending pending;
+	struct clk *clk_in;
+	struct notifier_block input_nb;
+	struct device *dev;
+	struct device_node *dn;
+	bool early;
+	struct clk_hw_onecell_data *onecell;
 	void __iomem *base;
-	u32 man_regs[LOGICLK_MANUAL_REGS];
-	u32 man_regs_stack[LOGICLK_MANUAL_REGS];
+	struct regmap *regmap;
+	const struct logiclk_family *family;
+	struct logiclk_limits limits;
+	const struct logiclk_solver *solver;
+	u32 *solver_table;
+	int solver_table_len;
+	u32 solver_budget;
+	bool frac_divide;
+	u32 tolerance;
+	bool vco_pinned;
+	u32 regs[2][LOGICLK_MANUAL_REGS];
+	u32 *man_regs;
+	struct mutex cfg_lock;
+	struct list_head list;
+	struct dentry *debugfs;
+	u32 dbg_output;
+	unsigned long dbg_rate;
+	u32 dbg_num;
+	struct work_struct config_work;
+	struct completion configured;
+	int config_err;
+	bool deferred;
+	struct mutex hw_lock;
+	u32 *hw_regs;
+	int hw_regs_num;
+	int irq;
+	struct completion locked;
+	struct delayed_work lock_monitor;
+	u32 lock_lost;
+	u32 lock_time;
+	struct logiclk_state committed;
+	u32 commit_failed;
+	u32 commits;
+	int prepared;
+	bool monitored;
+	struct reset_control *pwrdn;
+	bool powered_down;
 };
 
-#define to_logiclk_output(_hw) container_of(_hw, struct logiclk_output, hw)
+static LIST_HEAD(logiclk_list);
+static DEFINE_MUTEX(logiclk_list_lock);
+
+/* 7 series and UltraScale MMCM filter and lock lookup tables */
+static const u32 logiclk_lut_filter_high[MMCM_LUT_SIZE] = {
+	0x17C,
+	0x3FC,
+	0x3F4,
+	0x3E4,
+	0x3F8,
+	0x3C4,
+	0x3C4,
+	0x3D8,
+	0x3E8,
+	0x3E8,
+	0x3E8,
+	0x3B0,
+	0x3F0,
+	0x3F0,
+	0x3F0,
+	0x3F0,
+	0x3F0,
+	0x3F0,
+	0x3F0,
+	0x3F0,
+	0x3B0,
+	0x3B0,
+	0x3B0,
+	0x3E8,
+	0x370,
+	0x308,
+	0x370,
+	0x370,
+	0x3E8,
+	0x3E8,
+	0x3E8,
+	0x1C8,
+	0x330,
+	0x330,
+	0x3A8,
+	0x188,
+	0x188,
+	0x188,
+	0x1F0,
+	0x188,
+	0x110,
+	0x110,
+	0x110,
+	0x110,
+	0x110,
+	0x110,
+	0xE0,
+	0xE0,
+	0xE0,
+	0xE0,
+	0xE0,
+	0xE0,
+	0xE0,
+	0xE0,
+	0xE0,
+	0xE0,
+	0xE0,
+	0xE0,
+	0xE0,
+	0xE0,
+	0xE0,
+	0xE0,
+	0xE0,
+	0xE0
+};
+
+static const u32 logiclk_lut_filter_low[MMCM_LUT_SIZE] = {
+	0x5F,
+	0x57,
+	0x7B,
+	0x5B,
+	0x6B,
+	0x73,
+	0x73,
+	0x73,
+	0x73,
+	0x4B,
+	0x4B,
+	0x4B,
+	0xB3,
+	0x53,
+	0x53,
+	0x53,
+	0x53,
+	0x53,
+	0x53,
+	0x53,
+	0x53,
+	0x53,
+	0x53,
+	0x63,
+	0x63,
+	0x63,
+	0x63,
+	0x63,
+	0x63,
+	0x63,
+	0x63,
+	0x63,
+	0x63,
+	0x63,
+	0x63,
+	0x63,
+	0x63,
+	0x93,
+	0x93,
+	0x93,
+	0x93,
+	0x93,
+	0x93,
+	0x93,
+	0x93,
+	0x93,
+	0x93,
+	0xA3,
+	0xA3,
+	0xA3,
+	0xA3,
+	0xA3,
+	0xA3,
+	0xA3,
+	0xA3,
+	0xA3,
+	0xA3,
+	0xA3,
+	0xA3,
+	0xA3,
+	0xA3,
+	0xA3,
+	0xA3,
+	0xA3
+};
+
+static const u64 logiclk_lut_lock[MMCM_LUT_SIZE] = {
+	0x31BE8FA401ULL,
+	0x31BE8FA401ULL,
+	0x423E8FA401ULL,
+	0x5AFE8FA401ULL,
+	0x73BE8FA401ULL,
+	0x8C7E8FA401ULL,
+	0x9CFE8FA401ULL,
+	0xB5BE8FA401ULL,
+	0xCE7E8FA401ULL,
+	0xE73E8FA401ULL,
+	0xFFF84FA401ULL,
+	0xFFF39FA401ULL,
+	0xFFEEEFA401ULL,
+	0xFFEBCFA401ULL,
+	0xFFE8AFA401ULL,
+	0xFFE71FA401ULL,
+	0xFFE3FFA401ULL,
+	0xFFE26FA401ULL,
+	0xFFE0DFA401ULL,
+	0xFFDF4FA401ULL,
+	0xFFDDBFA401ULL,
+	0xFFDC2FA401ULL,
+	0xFFDA9FA401ULL,
+	0xFFD90FA401ULL,
+	0xFFD90FA401ULL,
+	0xFFD77FA401ULL,
+	0xFFD5EFA401ULL,
+	0xFFD5EFA401ULL,
+	0xFFD45FA401ULL,
+	0xFFD45FA401ULL,
+	0xFFD2CFA401ULL,
+	0xFFD2CFA401ULL,
+	0xFFD2CFA401ULL,
+	0xFFD13FA401ULL,
+	0xFFD13FA401ULL,
+	0xFFD13FA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL,
+	0xFFCFAFA401ULL
+};
+
+static const struct logiclk_family logiclk_family_7series = {
+	.limits = {
+		.input_freq_min = 10000000,
+		.input_freq_max = 800000000,
+		.output_freq_min = 4690000,
+		.output_freq_max = 800000000,
+		.vco_freq_min = 600000000ULL,
+		.vco_freq_max = 1600000000ULL,
+		.divclk_divide_min = 1,
+		.divclk_divide_max = 56,
+		.fbout_multiply_min = 2,
+		.fbout_multiply_max = 64,
+	},
+	.lut_filter_high = logiclk_lut_filter_high,
+	.lut_filter_low = logiclk_lut_filter_low,
+	.lut_lock = logiclk_lut_lock,
+};
 
-static void logiclk_stack_params(struct logiclk_output *output, bool flag)
+static const struct logiclk_family logiclk_family_ultrascale = {
+	.limits = {
+		.input_freq_min = 10000000,
+		.input_freq_max = 800000000,
+		.output_freq_min = 6250000,
+		.output_freq_max = 800000000,
+		.vco_freq_min = 600000000ULL,
+		.vco_freq_max = 1440000000ULL,
+		.divclk_divide_min = 1,
+		.divclk_divide_max = 56,
+		.fbout_multiply_min = 2,
+		.fbout_multiply_max = 64,
+	},
+	.lut_filter_high = logiclk_lut_filter_high,
+	.lut_filter_low = logiclk_lut_filter_low,
+	.lut_lock = logiclk_lut_lock,
+};
+
+static bool logiclk_regmap_writeable(struct device *dev, unsigned int reg)
 {
-	struct logiclk_data *data = output->data;
+	return (reg == LOGICLK_PLL_REG) || (reg >= LOGICLK_MAN_REG(0));
+}
 
-	if (flag == LOGICLK_STACK_PUSH) {
-		memcpy(&data->output_stack, output,
-			sizeof(struct logiclk_output));
-		memcpy(&data->man_regs_stack, data->man_regs,
-		       (sizeof(u32) * LOGICLK_MANUAL_REGS));
-	} else {
-		memcpy(output, &data->output_stack,
-			sizeof(struct logiclk_output));
-		memcpy(data->man_regs, &data->man_regs_stack,
-		       (sizeof(u32) * LOGICLK_MANUAL_REGS));
-	}
+static bool logiclk_regmap_volatile(struct device *dev, unsigned int reg)
+{
+	return reg == LOGICLK_PLL_REG;
 }
 
-static u32 logiclk_calc_freq(struct logiclk_output *output)
+/*
+ * Manual registers are cached with hw values read at init as defaults, so
+ * commits write only changed registers, and cache sync writes only
+ * registers differing from hw configuration.
+ */
+static const struct regmap_config logiclk_regmap_config = {
+	.reg_bits = 32,
+	.val_bits = 32,
+	.reg_stride = LOGICLK_REG_STRIDE,
+	.max_register = LOGICLK_MAN_REG(LOGICLK_MANUAL_REGS - 1),
+	.writeable_reg = logiclk_regmap_writeable,
+	.readable_reg = logiclk_regmap_writeable,
+	.volatile_reg = logiclk_regmap_volatile,
+	.cache_type = REGCACHE_FLAT,
+	.num_reg_defaults_raw = LOGICLK_PLL_MAN_REG_OFF +
+				LOGICLK_MANUAL_REGS,
+};
+
+#define to_logiclk_output(_hw) container_of(_hw, struct logiclk_output, hw)
+#define to_logiclk_data(_hw) container_of(_hw, struct logiclk_data, vco_hw)
+#define to_logiclk_data_nb(_nb) \
+	container_of(_nb, struct logiclk_data, input_nb)
+
+/* Output divider in 1/8 steps */
+static inline u32 logiclk_output_divide(struct logiclk_output *output)
+{
+	return (output->clkout_divide * MMCM_CLKOUT_FRAC_STEPS) +
+	       output->clkout_frac;
+}
+
+static u64 logiclk_calc_vco(struct logiclk_data *data)
 {
-	struct logiclk_data *data = output->data;
 	struct logiclk_input *input = &data->input;
 	u64 clk_freq_mult = (u64)input->clk_freq * (u64)input->clkfbout_mult;
-	u32 clk_freq_div = input->divclk_divide * output->clkout_divide;
 
-	return (u32)(div_u64(clk_freq_mult, clk_freq_div));
+	return div_u64(clk_freq_mult, input->divclk_divide);
+}
+
+static inline bool logiclk_vco_valid(struct logiclk_data *data, u64 freq_vco)
+{
+	return (freq_vco >= data->limits.vco_freq_min) &&
+	       (freq_vco <= data->limits.vco_freq_max);
+}
+
+static u32 logiclk_calc_freq(struct logiclk_output *output)
+{
+	u64 freq_vco = logiclk_calc_vco(output->data);
+
+	return (u32)(div_u64(freq_vco * MMCM_CLKOUT_FRAC_STEPS,
+			     logiclk_output_divide(output)));
 }
 
 static inline u32 logiclk_get_bits(u64 input, u32 msb, u32 lsb)
@@ -241,643 +757,2607 @@ static u32 logiclk_pll_count(u32 divide, u32 duty, s32 phase)
 		(logiclk_get_bits(pll_phase, 10, 9) << 24));
 }
 
-static u32 logiclk_pll_lut_filter(u32 divide, bool bw_high)
-{
-	static const u32 lut_high[] = {
-		0x17C,
-		0x3FC,
-		0x3F4,
-		0x3E4,
-		0x3F8,
-		0x3C4,
-		0x3C4,
-		0x3D8,
-		0x3E8,
-		0x3E8,
-		0x3E8,
-		0x3B0,
-		0x3F0,
-		0x3F0,
-		0x3F0,
-		0x3F0,
-		0x3F0,
-		0x3F0,
-		0x3F0,
-		0x3F0,
-		0x3B0,
-		0x3B0,
-		0x3B0,
-		0x3E8,
-		0x370,
-		0x308,
-		0x370,
-		0x370,
-		0x3E8,
-		0x3E8,
-		0x3E8,
-		0x1C8,
-		0x330,
-		0x330,
-		0x3A8,
-		0x188,
-		0x188,
-		0x188,
-		0x1F0,
-		0x188,
-		0x110,
-		0x110,
-		0x110,
-		0x110,
-		0x110,
-		0x110,
-		0xE0,
-		0xE0,
-		0xE0,
-		0xE0,
-		0xE0,
-		0xE0,
-		0xE0,
-		0xE0,
-		0xE0,
-		0xE0,
-		0xE0,
-		0xE0,
-		0xE0,
-		0xE0,
-		0xE0,
-		0xE0,
-		0xE0,
-		0xE0
-	};
-	static const u32 lut_low[] = {
-		0x5F,
-		0x57,
-		0x7B,
-		0x5B,
-		0x6B,
-		0x73,
-		0x73,
-		0x73,
-		0x73,
-		0x4B,
-		0x4B,
-		0x4B,
-		0xB3,
-		0x53,
-		0x53,
-		0x53,
-		0x53,
-		0x53,
-		0x53,
-		0x53,
-		0x53,
-		0x53,
-		0x53,
-		0x63,
-		0x63,
-		0x63,
-		0x63,
-		0x63,
-		0x63,
-		0x63,
-		0x63,
-		0x63,
-		0x63,
-		0x63,
-		0x63,
-		0x63,
-		0x63,
-		0x93,
-		0x93,
-		0x93,
-		0x93,
-		0x93,
-		0x93,
-		0x93,
-		0x93,
-		0x93,
-		0x93,
-		0xA3,
-		0xA3,
-		0xA3,
-		0xA3,
-		0xA3,
-		0xA3,
-		0xA3,
-		0xA3,
-		0xA3,
-		0xA3,
-		0xA3,
-		0xA3,
-		0xA3,
-		0xA3,
-		0xA3,
-		0xA3,
-		0xA3
-	};
+/*
+ * Fractional counter with 50% duty cycle for CLKOUT0_DIVIDE_F.
+ * Bits 31:0 are set into CLKOUT0 registers, bits 35:32 hold falling edge
+ * phase mux and waveform set into CLKOUT5 second register.
+ */
+static u64 logiclk_pll_frac_count(u32 divide, u32 frac, s32 phase)
+{
+	u32 even_part, odd, odd_and_frac, lt_frac, ht_frac, pm_fall;
+	u32 wf_fall_frac, wf_rise_frac, per_octets, pm_rise_frac;
+	u32 pm_fall_frac, delay_time, pll_phase;
+	u32 phase_fixed = (phase < 0) ? (phase + MMCM_PHASE_MAX) : phase;
+
+	even_part = divide >> 1;
+	odd = divide - (even_part << 1);
+	odd_and_frac = (MMCM_CLKOUT_FRAC_STEPS * odd) + frac;
+
+	lt_frac = even_part - (odd_and_frac <= 9);
+	ht_frac = even_part - (odd_and_frac <= 8);
+
+	pm_fall = (odd << 2) + (frac >> 1);
+
+	wf_fall_frac = ((odd_and_frac >= 2) && (odd_and_frac <= 9)) ||
+		       ((frac == 1) && (divide == 2));
+	wf_rise_frac = (odd_and_frac >= 1) && (odd_and_frac <= 8);
+
+	/* phase in 1/8 VCO cycles, with rounding offset */
+	per_octets = (MMCM_CLKOUT_FRAC_STEPS * divide) + frac;
+	pm_rise_frac = (((phase_fixed + 10) * per_octets) / MMCM_PHASE_MAX) &
+		       0x7;
+	delay_time = (((phase_fixed + 10) * per_octets) /
+		      MMCM_CLKOUT_FRAC_STEPS) / MMCM_PHASE_MAX;
+	pm_fall_frac = (pm_fall + pm_rise_frac) & 0x7;
+
+	pll_phase = logiclk_pll_phase(divide, phase);
+
+	return ((u64)(lt_frac & 0x3F) |
+		((u64)(ht_frac & 0x3F) << 6) |
+		((u64)pm_rise_frac << 13) |
+		((u64)(delay_time & 0x3F) << 16) |
+		((u64)logiclk_get_bits(pll_phase, 10, 9) << 24) |
+		((u64)wf_rise_frac << 26) |
+		(1ULL << 27) |
+		((u64)(frac & 0x7) << 28) |
+		((u64)wf_fall_frac << 32) |
+		((u64)pm_fall_frac << 33));
+}
 
+static u32 logiclk_pll_lut_filter(const struct logiclk_family *family,
+				  u32 divide, bool bw_high)
+{
 	if (bw_high)
-		return lut_high[divide - 1];
+		return family->lut_filter_high[divide - 1];
 	else
-		return lut_low[divide - 1];
-}
-
-static u64 logiclk_pll_lut_lock(u32 divide)
-{
-	static const u64 lut[] = {
-		0x31BE8FA401ULL,
-		0x31BE8FA401ULL,
-		0x423E8FA401ULL,
-		0x5AFE8FA401ULL,
-		0x73BE8FA401ULL,
-		0x8C7E8FA401ULL,
-		0x9CFE8FA401ULL,
-		0xB5BE8FA401ULL,
-		0xCE7E8FA401ULL,
-		0xE73E8FA401ULL,
-		0xFFF84FA401ULL,
-		0xFFF39FA401ULL,
-		0xFFEEEFA401ULL,
-		0xFFEBCFA401ULL,
-		0xFFE8AFA401ULL,
-		0xFFE71FA401ULL,
-		0xFFE3FFA401ULL,
-		0xFFE26FA401ULL,
-		0xFFE0DFA401ULL,
-		0xFFDF4FA401ULL,
-		0xFFDDBFA401ULL,
-		0xFFDC2FA401ULL,
-		0xFFDA9FA401ULL,
-		0xFFD90FA401ULL,
-		0xFFD90FA401ULL,
-		0xFFD77FA401ULL,
-		0xFFD5EFA401ULL,
-		0xFFD5EFA401ULL,
-		0xFFD45FA401ULL,
-		0xFFD45FA401ULL,
-		0xFFD2CFA401ULL,
-		0xFFD2CFA401ULL,
-		0xFFD2CFA401ULL,
-		0xFFD13FA401ULL,
-		0xFFD13FA401ULL,
-		0xFFD13FA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL,
-		0xFFCFAFA401ULL
-	};
-
-	return lut[divide - 1];
-}
-
-static int logiclk_pll_input_mult_div(struct logiclk_output *output)
+		return family->lut_filter_low[divide - 1];
+}
+
+static u64 logiclk_pll_lut_lock(const struct logiclk_family *family,
+				u32 divide)
 {
-	struct logiclk_data *data = output->data;
-	struct logiclk_input *input = &data->input;
-	u64 clk_freq_input = input->clk_freq;
-	u64 freq_err = ((u64)-1);
-	u64 freq_out = output->clkout_freq;
-	u64 clk_freq, clkfbout_mult, freq_err_new;
-	u32 clkout_divide, divclk_divide;
+	return family->lut_lock[divide - 1];
+}
 
-	input->clkfbout_mult = 0;
-	input->divclk_divide = 0;
+static void logiclk_solution_init(struct logiclk_solution *sol, u32 budget)
+{
+	sol->clkfbout_mult = 0;
+	sol->divclk_divide = 0;
+	sol->freq_err = ((u64)-1);
+	sol->iterations = 0;
+	sol->budget = budget;
+	sol->exhausted = false;
+}
 
-	for (divclk_divide = MMCM_DIVCLK_DIVIDE_MIN;
-	     divclk_divide <= MMCM_DIVCLK_DIVIDE_MAX;
-	     divclk_divide++) {
-		for (clkfbout_mult = MMCM_FBOUT_MULTIPLY_MIN;
-		     clkfbout_mult <= MMCM_FBOUT_MULTIPLY_MAX;
-		     clkfbout_mult++) {
-			for (clkout_divide = MMCM_CLKOUT_DIVIDE_MIN;
-			     clkout_divide <= MMCM_CLKOUT_DIVIDE_MAX;
-			     clkout_divide++) {
-				clk_freq = clk_freq_input * clkfbout_mult;
-				clk_freq = div_u64(clk_freq, divclk_divide);
+/*
+ * Account next evaluated configuration.
+ * Returns false when iterations budget is spent and search must stop.
+ */
+static bool logiclk_solution_next(struct logiclk_solution *sol)
+{
+	if (sol->budget && (sol->iterations >= sol->budget)) {
+		sol->exhausted = true;
+		return false;
+	}
 
-				if ((clk_freq < MMCM_VCO_FREQ_MIN) ||
-				    (clk_freq > MMCM_VCO_FREQ_MAX))
-					continue;
+	sol->iterations++;
 
-				clk_freq = div_u64(clk_freq, clkout_divide);
-				freq_err_new = abs64((clk_freq - freq_out));
+	return true;
+}
+
+/*
+ * Keep the first configuration with the lowest error.
+ * Returns true when exact frequency is found and search can stop.
+ */
+static bool logiclk_solution_update(struct logiclk_solution *sol,
+				    u32 clkfbout_mult, u32 divclk_divide,
+				    u64 freq_err)
+{
+	if (freq_err >= sol->freq_err)
+		return false;
 
-				if (freq_err_new < freq_err) {
-					input->clkfbout_mult = clkfbout_mult;
-					input->divclk_divide = divclk_divide;
+	sol->clkfbout_mult = clkfbout_mult;
+	sol->divclk_divide = divclk_divide;
+	sol->freq_err = freq_err;
 
-					if (freq_err_new == 0)
-						return 0;
-					else
-						freq_err = freq_err_new;
-				}
-			}
+	return (freq_err == 0);
+}
+
+/*
+ * Fractional divider search in 1/8 steps. Fractional values are valid
+ * from 2.125, below that only integer dividers are used.
+ */
+static u64 logiclk_pll_vco_err_frac(u64 freq_vco, u64 freq_out,
+				    u32 *clkout_divide, u32 *clkout_frac)
+{
+	u64 freq_vco_frac = freq_vco * MMCM_CLKOUT_FRAC_STEPS;
+	u64 freq_err, freq_err_next;
+	u32 divide, divide_next;
+	u32 divide_min = MMCM_CLKOUT_DIVIDE_MIN * MMCM_CLKOUT_FRAC_STEPS;
+	u32 divide_frac_min = MMCM_CLKOUT_DIVIDE_F_MIN * MMCM_CLKOUT_FRAC_STEPS;
+	u32 divide_max = MMCM_CLKOUT_DIVIDE_MAX * MMCM_CLKOUT_FRAC_STEPS;
+
+	divide = (u32)clamp_t(u64, div64_u64(freq_vco_frac, freq_out),
+			      divide_min, divide_max);
+	divide_next = divide + 1;
+	if (divide < divide_frac_min) {
+		divide = rounddown(divide, MMCM_CLKOUT_FRAC_STEPS);
+		divide_next = roundup(divide_next, MMCM_CLKOUT_FRAC_STEPS);
+	}
+
+	freq_err = abs((s64)(div_u64(freq_vco_frac, divide) - freq_out));
+
+	if (divide_next <= divide_max) {
+		freq_err_next = abs((s64)(div_u64(freq_vco_frac, divide_next) -
+					 freq_out));
+		if (freq_err_next < freq_err) {
+			freq_err = freq_err_next;
+			divide = divide_next;
 		}
 	}
 
-	if ((input->clkfbout_mult == 0) || (input->divclk_divide == 0))
-		return -EINVAL;
+	*clkout_divide = divide / MMCM_CLKOUT_FRAC_STEPS;
+	*clkout_frac = divide % MMCM_CLKOUT_FRAC_STEPS;
 
-	return 0;
+	return freq_err;
 }
 
-static u32 logiclk_pll_output_div(struct logiclk_output *output)
+/*
+ * Output frequency is truncated VCO frequency divided with output divider,
+ * which is non-increasing with the divider. Closest output frequency is
+ * therefore given either with divider VCO/freq_out or the next one.
+ */
+static u64 logiclk_pll_vco_err(u64 freq_vco, u64 freq_out, bool frac,
+			       u32 *clkout_divide, u32 *clkout_frac)
 {
-	struct logiclk_data *data = output->data;
-	struct logiclk_input *input = &data->input;
-	u64 clk_freq_mult = (u64)input->clk_freq * (u64)input->clkfbout_mult;
-	u64 freq_err = ((u64)-1);
-	u64 freq_out = output->clkout_freq;
-	u64 freq, freq_err_new, freq_mult_div;
-	u32 clkout_div = 0;
-	u32 clkout_divide;
+	u64 freq_err, freq_err_next;
+	u32 divide;
+
+	*clkout_frac = 0;
 
-	freq_mult_div = div_u64(clk_freq_mult, input->divclk_divide);
+	if (freq_out == 0) {
+		*clkout_divide = MMCM_CLKOUT_DIVIDE_MAX;
+		return div_u64(freq_vco, MMCM_CLKOUT_DIVIDE_MAX);
+	}
 
-	for (clkout_divide = MMCM_CLKOUT_DIVIDE_MIN;
-	     clkout_divide <= MMCM_CLKOUT_DIVIDE_MAX;
-	     clkout_divide++) {
-		freq = div_u64(freq_mult_div, clkout_divide);
-		freq_err_new = abs64((freq - freq_out));
+	if (frac)
+		return logiclk_pll_vco_err_frac(freq_vco, freq_out,
+						clkout_divide, clkout_frac);
 
-		if (freq_err_new < freq_err) {
-			clkout_div = clkout_divide;
+	divide = (u32)clamp_t(u64, div64_u64(freq_vco, freq_out),
+			      MMCM_CLKOUT_DIVIDE_MIN, MMCM_CLKOUT_DIVIDE_MAX);
+	freq_err = abs((s64)(div_u64(freq_vco, divide) - freq_out));
 
-			if (freq_err_new == 0)
-				return clkout_div;
-			else
-				freq_err = freq_err_new;
+	if (divide < MMCM_CLKOUT_DIVIDE_MAX) {
+		freq_err_next = abs((s64)(div_u64(freq_vco, divide + 1) -
+					 freq_out));
+		if (freq_err_next < freq_err) {
+			freq_err = freq_err_next;
+			divide++;
 		}
 	}
 
-	return clkout_div;
+	*clkout_divide = divide;
+
+	return freq_err;
 }
 
-static void logiclk_man_reg_params_id(struct logiclk_input *input,
-				      struct logiclk_output *output,
-				      unsigned int id)
+static bool logiclk_solution_update_vco(struct logiclk_solution *sol,
+					u32 clkfbout_mult, u32 divclk_divide,
+					u64 freq_vco, u64 freq_out)
 {
-	struct logiclk_data *data = output->data;
-	u64 clk_freq_mult, clk_freq_mult_div;
-	u32 clkout;
+	u32 clkout_divide, clkout_frac;
 
-	clk_freq_mult = (u64)input->clk_freq * (u64)input->clkfbout_mult;
-	clk_freq_mult_div = div_u64(clk_freq_mult, input->divclk_divide);
+	return logiclk_solution_update(sol, clkfbout_mult, divclk_divide,
+				       logiclk_pll_vco_err(freq_vco, freq_out,
+							   sol->frac,
+							   &clkout_divide,
+							   &clkout_frac));
+}
 
-	output->clkout_divide = logiclk_pll_output_div(output);
+/*
+ * Input multipliers giving VCO frequency within allowed range for the given
+ * input divider. Returns false if there are none.
+ */
+static bool logiclk_mult_range(struct logiclk_data *data, u32 divclk_divide,
+			       u32 *mult_min, u32 *mult_max)
+{
+	const struct logiclk_limits *limits = &data->limits;
+	u64 clk_freq_input = data->input.clk_freq;
+	u64 min, max;
+
+	min = div_u64((limits->vco_freq_min * divclk_divide) +
+		      clk_freq_input - 1, clk_freq_input);
+	max = div_u64(((limits->vco_freq_max + 1) * divclk_divide) - 1,
+		      clk_freq_input);
+	min = max_t(u64, min, limits->fbout_multiply_min);
+	max = min_t(u64, max, limits->fbout_multiply_max);
+	if (min > max)
+		return false;
+
+	*mult_min = (u32)min;
+	*mult_max = (u32)max;
+
+	return true;
+}
 
-	clkout = logiclk_pll_count(output->clkout_divide,
-				   output->clkout_duty,
-				   output->clkout_phase);
+/*
+ * Evaluate one input multiplier and divider pair.
+ * Returns true when search must stop, on exact frequency or spent budget.
+ */
+static bool logiclk_solve_mult(struct logiclk_data *data, u32 clkfbout_mult,
+			       u32 divclk_divide, u64 freq_out,
+			       struct logiclk_solution *sol)
+{
+	u64 clk_freq;
 
-	data->man_regs[LOGICLK_PLL_REG_OFF + (id * 2)] =
-		logiclk_get_bits(clkout, 15, 0);
-	data->man_regs[(LOGICLK_PLL_REG_OFF + 1) + (id * 2)] =
-		logiclk_get_bits(clkout, 31, 16);
+	if (!logiclk_solution_next(sol))
+		return true;
+
+	clk_freq = div_u64((u64)data->input.clk_freq * clkfbout_mult,
+			   divclk_divide);
 
-	output->clkout_freq = (u32)div_u64(clk_freq_mult_div,
-					   output->clkout_divide);
+	return logiclk_solution_update_vco(sol, clkfbout_mult, divclk_divide,
+					   clk_freq, freq_out);
 }
 
-static void logiclk_man_reg_params(struct logiclk_input *input,
-				   struct logiclk_output *output)
+/*
+ * Search input multipliers giving VCO frequency within allowed range for
+ * the given input divider, outwards from the multiplier giving requested
+ * frequency with output divider of current VCO. Budgeted search evaluates
+ * configurations close to the optimum first, and of configurations with
+ * equal error the one closest to current VCO is kept.
+ */
+static bool logiclk_solve_divclk(struct logiclk_data *data, u32 divclk_divide,
+				 u64 freq_out, struct logiclk_solution *sol)
 {
-	struct logiclk_data *data = output->data;
-	u64 lock;
-	u32 clkfbout, divclk, filter;
+	u64 clk_freq_input = data->input.clk_freq;
+	u32 mult_min, mult_max, clkout_divide, clkout_frac;
+	bool in_range = true;
+	u64 mult;
+	u32 step;
+
+	if (!logiclk_mult_range(data, divclk_divide, &mult_min, &mult_max))
+		return false;
+
+	/* M = freq_out * D * O / input, with O in 1/8 steps */
+	logiclk_pll_vco_err(logiclk_calc_vco(data), freq_out, sol->frac,
+			    &clkout_divide, &clkout_frac);
+	mult = div64_u64((freq_out * divclk_divide *
+			  ((clkout_divide * MMCM_CLKOUT_FRAC_STEPS) +
+			   clkout_frac)) +
+			 ((clk_freq_input * MMCM_CLKOUT_FRAC_STEPS) / 2),
+			 clk_freq_input * MMCM_CLKOUT_FRAC_STEPS);
+	mult = clamp_t(u64, mult, mult_min, mult_max);
+
+	for (step = 0; in_range; step++) {
+		in_range = false;
+
+		if (mult >= (mult_min + step)) {
+			in_range = true;
+			if (logiclk_solve_mult(data, (u32)(mult - step),
+					       divclk_divide, freq_out, sol))
+				return true;
+		}
+		if (step && ((mult + step) <= mult_max)) {
+			in_range = true;
+			if (logiclk_solve_mult(data, (u32)(mult + step),
+					       divclk_divide, freq_out, sol))
+				return true;
+		}
+	}
 
-	clkfbout = logiclk_pll_count(input->clkfbout_mult,
-				     output->clkout_duty,
-				     input->clkfbout_phase);
-	divclk = logiclk_pll_count(input->divclk_divide,
-				   output->clkout_duty,
-				   output->clkout_phase);
+	return false;
+}
 
-	filter = logiclk_pll_lut_filter((input->clkfbout_mult - 1),
-					input->bw_high);
+static int logiclk_solve_exhaustive(struct logiclk_data *data, u64 freq_out,
+				    struct logiclk_solution *sol)
+{
+	const struct logiclk_limits *limits = &data->limits;
+	u64 clk_freq_input = data->input.clk_freq;
+	u64 clk_freq, clkfbout_mult, freq_err_new;
+	u32 clkout_divide, divclk_divide;
 
-	lock = logiclk_pll_lut_lock(input->clkfbout_mult - 1);
+	for (divclk_divide = limits->divclk_divide_min;
+	     divclk_divide <= limits->divclk_divide_max;
+	     divclk_divide++) {
+		for (clkfbout_mult = limits->fbout_multiply_min;
+		     clkfbout_mult <= limits->fbout_multiply_max;
+		     clkfbout_mult++) {
+			for (clkout_divide = MMCM_CLKOUT_DIVIDE_MIN;
+			     clkout_divide <= MMCM_CLKOUT_DIVIDE_MAX;
+			     clkout_divide++) {
+				if (!logiclk_solution_next(sol))
+					return 0;
 
-	data->man_regs[0] = 0xFFFF;
+				clk_freq = clk_freq_input * clkfbout_mult;
+				clk_freq = div_u64(clk_freq, divclk_divide);
 
-	data->man_regs[13] = (logiclk_get_bits(divclk, 23, 22) << 12) |
-			     (logiclk_get_bits(divclk, 11, 0) << 0);
-	data->man_regs[14] = logiclk_get_bits(clkfbout, 15, 0);
-	data->man_regs[15] = logiclk_get_bits(clkfbout, 31, 16);
-	data->man_regs[16] = logiclk_get_bits(lock, 29, 20);
-	data->man_regs[17] = (logiclk_get_bits(lock, 34, 30) << 10) |
-			     logiclk_get_bits(lock, 9, 0);
-	data->man_regs[18] = (logiclk_get_bits(lock, 39, 35) << 10) |
-			     logiclk_get_bits(lock, 19, 10);
-	data->man_regs[19] = (logiclk_get_bits(filter, 6, 6) << 8)  |
-			     (logiclk_get_bits(filter, 8, 7) << 11) |
-			     (logiclk_get_bits(filter, 9, 9) << 15);
-	data->man_regs[20] = (logiclk_get_bits(filter, 0, 0) << 4)  |
-			     (logiclk_get_bits(filter, 2, 1) << 7)  |
-			     (logiclk_get_bits(filter, 4, 3) << 11) |
-			     (logiclk_get_bits(filter, 5, 5) << 15);
-}
+				if ((clk_freq < limits->vco_freq_min) ||
+				    (clk_freq > limits->vco_freq_max))
+					continue;
 
-static int logiclk_calc_params(struct logiclk_output *output)
-{
-	struct logiclk_data *data = output->data;
-	struct logiclk_input *input = &data->input;
-	struct device *dev = &data->pdev->dev;
-	int i, ret;
+				clk_freq = div_u64(clk_freq, clkout_divide);
+				freq_err_new = abs((s64)(clk_freq - freq_out));
 
-	if ((output->clkout_freq < MMCM_OUTPUT_FREQ_MIN) ||
-	    (output->clkout_freq > MMCM_OUTPUT_FREQ_MAX)) {
-		dev_err(dev, "invalid output frequency %u Hz\n",
-			output->clkout_freq);
-		return -EINVAL;
+				if (logiclk_solution_update(sol, clkfbout_mult,
+							    divclk_divide,
+							    freq_err_new))
+					return 0;
+			}
+		}
 	}
 
-	if (output->precise) {
-		ret = logiclk_pll_input_mult_div(output);
-		if (ret)
-			return ret;
-		logiclk_man_reg_params(input, output);
-		/*
-		 * recalculate all output parameters with new input
-		 * multiplier and divider
-		 */
-		for (i = 0; i < LOGICLK_OUTPUTS; i++)
-			logiclk_man_reg_params_id(input, &data->output[i],
-						  data->output[i].id);
-	} else {
-		logiclk_man_reg_params_id(input, output, output->id);
-	}
+	return 0;
+}
+
+static int logiclk_solve_pruned(struct logiclk_data *data, u64 freq_out,
+				struct logiclk_solution *sol)
+{
+	const struct logiclk_limits *limits = &data->limits;
+	u32 divclk_divide;
+
+	for (divclk_divide = limits->divclk_divide_min;
+	     divclk_divide <= limits->divclk_divide_max;
+	     divclk_divide++)
+		if (logiclk_solve_divclk(data, divclk_divide, freq_out, sol))
+			break;
 
 	return 0;
 }
 
-static int logiclk_hw_config(struct logiclk_output *output, bool config)
+static int logiclk_solve_table(struct logiclk_data *data, u64 freq_out,
+			       struct logiclk_solution *sol)
 {
-	struct logiclk_data *data = output->data;
-	struct device *dev = &data->pdev->dev;
-	int cnt = PLL_LOCK_TIME_INTERVALS;
-	u32 cfg = LOGICLK_PLL_CONFIG;
-	u32 val;
+	const struct logiclk_limits *limits = &data->limits;
+	u64 clk_freq_input = data->input.clk_freq;
+	u64 clk_freq;
+	u32 clkfbout_mult, divclk_divide;
 	int i;
 
-	if (config == LOGICLK_CONFIG_SW) {
-		for (i = 0; i < LOGICLK_MANUAL_REGS; i++)
-			clk_writel(data->man_regs[i],
-				   (data->base +
-				   ((i + LOGICLK_PLL_MAN_REG_OFF) *
-				   LOGICLK_REG_STRIDE)));
+	for (i = 0; i < data->solver_table_len; i++) {
+		clkfbout_mult = data->solver_table[(i * 2)];
+		divclk_divide = data->solver_table[(i * 2) + 1];
 
-		cfg |= LOGICLK_PLL_CONFIG_SW;
-	}
+		if (!logiclk_solution_next(sol))
+			break;
+
+		clk_freq = div_u64(clk_freq_input * clkfbout_mult,
+				   divclk_divide);
 
-	while (1) {
-		val = clk_readl(data->base + (LOGICLK_PLL_REG_OFF *
-				LOGICLK_REG_STRIDE));
-		if (val & LOGICLK_PLL_LOCK) {
-			clk_writel(cfg, (data->base + (LOGICLK_PLL_REG_OFF *
-				   LOGICLK_REG_STRIDE)));
+		if ((clk_freq < limits->vco_freq_min) ||
+		    (clk_freq > limits->vco_freq_max))
+			continue;
+
+		if (logiclk_solution_update_vco(sol, clkfbout_mult,
+						divclk_divide, clk_freq,
+						freq_out))
 			break;
+	}
+
+	return 0;
+}
+
+/*
+ * Search input dividers outwards from the current one, so small rate
+ * changes find an exact configuration close to the current VCO first.
+ */
+static int logiclk_solve_incremental(struct logiclk_data *data, u64 freq_out,
+				     struct logiclk_solution *sol)
+{
+	const struct logiclk_limits *limits = &data->limits;
+	u32 divclk_divide = clamp_t(u32, data->input.divclk_divide,
+				    limits->divclk_divide_min,
+				    limits->divclk_divide_max);
+	bool in_range = true;
+	u32 step;
+
+	for (step = 0; in_range; step++) {
+		in_range = false;
+
+		if (divclk_divide >= (limits->divclk_divide_min + step)) {
+			in_range = true;
+			if (logiclk_solve_divclk(data, (divclk_divide - step),
+						 freq_out, sol))
+				break;
 		}
-		if (cnt-- == 0) {
-			dev_err(dev, "failed pll lock\n");
-			return -EIO;
+		if (step &&
+		    ((divclk_divide + step) <= limits->divclk_divide_max)) {
+			in_range = true;
+			if (logiclk_solve_divclk(data, (divclk_divide + step),
+						 freq_out, sol))
+				break;
 		}
-		mdelay(PLL_LOCK_TIME_MS);
 	}
 
 	return 0;
 }
 
-static unsigned long logiclk_recalc_rate(struct clk_hw *hw,
-					 unsigned long parent_rate)
+static const struct logiclk_solver logiclk_solvers[] = {
+	{
+		.name = "exhaustive",
+		.solve = logiclk_solve_exhaustive,
+	},
+	{
+		.name = "pruned",
+		.solve = logiclk_solve_pruned,
+	},
+	{
+		.name = "table",
+		.solve = logiclk_solve_table,
+	},
+	{
+		.name = "incremental",
+		.solve = logiclk_solve_incremental,
+	},
+};
+
+static const struct logiclk_solver *logiclk_get_solver(const char *name)
 {
-	struct logiclk_output *output = to_logiclk_output(hw);
-	struct logiclk_data *data = output->data;
-	struct logiclk_input *input = &data->input;
-	u64 clk_freq_mult = (u64)input->clk_freq * (u64)input->clkfbout_mult;
-	unsigned long rate;
+	int i;
 
-	if (output->clkout_freq == 0) {
-		/*
-		 * Instead IO access, take parameters from struct logiclk_data.
-		 * The same parameters are set in logiCLK hw registers.
-		 */
-		rate = (unsigned long)(div_u64(clk_freq_mult,
-					       input->divclk_divide));
-		output->clkout_freq = (rate / output->clkout_divide);
-	}
+	for (i = 0; i < ARRAY_SIZE(logiclk_solvers); i++)
+		if (!strcmp(logiclk_solvers[i].name, name))
+			return &logiclk_solvers[i];
 
-	logiclk_man_reg_params(input, output);
-	logiclk_man_reg_params_id(input, output, output->id);
+	return NULL;
+}
 
-	return (unsigned long)output->clkout_freq;
+static void logiclk_solver_verify(struct logiclk_data *data, u64 freq_out,
+				  struct logiclk_solution *sol)
+{
+	struct device *dev = data->dev;
+	struct logiclk_solution ref;
+
+	/* reference search covers integer output dividers only */
+	if (sol->frac || (!sol->exhausted &&
+			  (data->solver->solve == logiclk_solve_exhaustive)))
+		return;
+
+	logiclk_solution_init(&ref, 0);
+	logiclk_solve_exhaustive(data, freq_out, &ref);
+
+	/* configurations with equal error may differ in search order */
+	if (sol->exhausted)
+		dev_info(dev,
+			 "%s solver budget %u spent at %llu Hz: error %llu Hz, %llu Hz from optimum\n",
+			 data->solver->name, sol->budget, freq_out,
+			 sol->freq_err, sol->freq_err - ref.freq_err);
+	else if (ref.freq_err != sol->freq_err)
+		dev_warn(dev,
+			 "%s solver mismatch at %llu Hz: M %u D %u error %llu Hz, reference M %u D %u error %llu Hz\n",
+			 data->solver->name, freq_out,
+			 sol->clkfbout_mult, sol->divclk_divide, sol->freq_err,
+			 ref.clkfbout_mult, ref.divclk_divide, ref.freq_err);
 }
 
-static long logiclk_round_rate(struct clk_hw *hw, unsigned long rate,
-			       unsigned long *parent_rate)
+static int logiclk_pll_input_mult_div(struct logiclk_output *output,
+				      u64 freq_out,
+				      struct logiclk_solution *sol)
 {
-	struct logiclk_output *output = to_logiclk_output(hw);
 	struct logiclk_data *data = output->data;
-	struct device *dev = &data->pdev->dev;
-
-	logiclk_stack_params(output, LOGICLK_STACK_PUSH);
-
-	output->clkout_freq = rate;
-
-	if (logiclk_calc_params(output)) {
-		dev_err(dev, "failed parameters calculation\n");
-		logiclk_stack_params(output, LOGICLK_STACK_POP);
+	struct device *dev = data->dev;
+	ktime_t start;
+	int ret;
+
+	logiclk_solution_init(sol, data->solver_budget);
+	sol->frac = data->frac_divide && (output->id == 0);
+
+	start = ktime_get();
+	ret = data->solver->solve(data, freq_out, sol);
+	dev_dbg(dev,
+		"%s solver: %llu Hz, M %u D %u, error %llu Hz, %u iterations, %lld ns\n",
+		data->solver->name, freq_out, sol->clkfbout_mult,
+		sol->divclk_divide, sol->freq_err, sol->iterations,
+		ktime_to_ns(ktime_sub(ktime_get(), start)));
+	if (ret)
+		return ret;
+
+	if (sol->exhausted && sol->clkfbout_mult)
+		dev_dbg(dev,
+			"solver budget spent, error %llu ppm from requested frequency\n",
+			div64_u64(sol->freq_err * 1000000, freq_out));
+
+	if ((sol->clkfbout_mult == 0) || (sol->divclk_divide == 0))
 		return -EINVAL;
-	}
 
-	return (long)output->clkout_freq;
+	if (IS_ENABLED(CONFIG_COMMON_CLK_LOGICLK_VERIFY))
+		logiclk_solver_verify(data, freq_out, sol);
+
+	return 0;
 }
 
-static int logiclk_set_rate(struct clk_hw *hw, unsigned long rate,
-			    unsigned long parent_rate)
+static inline u64 logiclk_freq_tol(struct logiclk_data *data, u64 freq_out)
+{
+	return div_u64(freq_out * data->tolerance, LOGICLK_TOLERANCE_MAX);
+}
+
+/*
+ * Cost model for precise output. Keeping current input multiplier and
+ * divider changes only output divider, while new ones relock MMCM and
+ * retune all outputs. Solver result is taken only when current VCO misses
+ * tolerance and solver gives smaller frequency error.
+ * Returns true if current input multiplier and divider are kept, otherwise
+ * @sol holds new configuration.
+ */
+static bool logiclk_pll_input_keep(struct logiclk_output *output,
+				   u64 freq_out, struct logiclk_solution *sol)
 {
-	struct logiclk_output *output = to_logiclk_output(hw);
 	struct logiclk_data *data = output->data;
-	struct device *dev = &data->pdev->dev;
+	struct device *dev = data->dev;
+	u64 freq_vco = logiclk_calc_vco(data);
+	u32 clkout_div, clkout_frac;
+	u64 freq_err = ((u64)-1);
 
-	if (rate != output->clkout_freq) {
-		logiclk_stack_params(output, LOGICLK_STACK_PUSH);
-		output->clkout_freq = rate;
-		if (logiclk_calc_params(output)) {
-			dev_err(dev, "failed parameters calculation\n");
-			logiclk_stack_params(output, LOGICLK_STACK_POP);
-			return -EINVAL;
+	/* current VCO outside limits is replaced by any solver result */
+	if (logiclk_vco_valid(data, freq_vco)) {
+		freq_err = logiclk_pll_vco_err(freq_vco, freq_out,
+					       (data->frac_divide &&
+						(output->id == 0)),
+					       &clkout_div, &clkout_frac);
+		if (freq_err <= logiclk_freq_tol(data, freq_out))
+			goto keep;
+	}
+
+	if (logiclk_pll_input_mult_div(output, freq_out, sol) ||
+	    (sol->freq_err >= freq_err))
+		goto keep;
+
+	return false;
+
+keep:
+	dev_dbg(dev, "keeping M %u D %u, error %llu Hz\n",
+		data->input.clkfbout_mult, data->input.divclk_divide, freq_err);
+
+	return true;
+}
+
+/*
+ * VCO input multiplier and divider closest to requested VCO frequency.
+ * Returns VCO frequency, or 0 if no configuration is within limits.
+ */
+static u64 logiclk_pll_vco_mult_div(struct logiclk_data *data, u64 freq_vco,
+				    u32 *clkfbout_mult, u32 *divclk_divide)
+{
+	const struct logiclk_limits *limits = &data->limits;
+	u64 clk_freq = data->input.clk_freq;
+	u64 vco, best = 0, err, best_err = ((u64)-1);
+	u32 d, m;
+
+	for (d = limits->divclk_divide_min;
+	     d <= limits->divclk_divide_max; d++) {
+		m = (u32)div64_u64((freq_vco * d) + (clk_freq / 2), clk_freq);
+		m = clamp(m, limits->fbout_multiply_min,
+			  limits->fbout_multiply_max);
+
+		vco = div_u64(clk_freq * m, d);
+		if ((vco < limits->vco_freq_min) ||
+		    (vco > limits->vco_freq_max))
+			continue;
+
+		err = abs((s64)(vco - freq_vco));
+		if (err < best_err) {
+			best_err = err;
+			best = vco;
+			*clkfbout_mult = m;
+			*divclk_divide = d;
+		}
+	}
+
+	return best;
+}
+
+static u32 logiclk_pll_output_div(struct logiclk_output *output,
+				  u64 freq_vco, u64 freq_out,
+				  u32 *clkout_frac)
+{
+	struct logiclk_data *data = output->data;
+	u32 clkout_div;
+
+	logiclk_pll_vco_err(freq_vco, freq_out,
+			    (data->frac_divide && (output->id == 0)),
+			    &clkout_div, clkout_frac);
+
+	return clkout_div;
+}
+
+/* Output frequency given by divider closest to requested frequency */
+static u32 logiclk_pll_output_freq(struct logiclk_output *output,
+				   u64 freq_vco, u64 freq_out)
+{
+	u32 clkout_div, clkout_frac;
+
+	clkout_div = logiclk_pll_output_div(output, freq_vco, freq_out,
+					    &clkout_frac);
+
+	return (u32)div_u64(freq_vco * MMCM_CLKOUT_FRAC_STEPS,
+			    (clkout_div * MMCM_CLKOUT_FRAC_STEPS) +
+			    clkout_frac);
+}
+
+/*
+ * Insert candidate sorted by output frequency error, with configuration
+ * without relock first for equal error. Same VCO frequency gives the same
+ * output frequencies, so it is listed only once, preferring current input
+ * multiplier and divider.
+ */
+static unsigned int logiclk_candidate_insert(struct logiclk_candidate *cand,
+					     unsigned int cnt, unsigned int num,
+					     struct logiclk_candidate *new)
+{
+	unsigned int i, pos;
+
+	for (i = 0; i < cnt; i++)
+		if (cand[i].vco_rate == new->vco_rate)
+			break;
+	if (i < cnt) {
+		if (new->relock || !cand[i].relock)
+			return cnt;
+		memmove(&cand[i], &cand[i + 1], (cnt - i - 1) * sizeof(*cand));
+		cnt--;
+	}
+
+	for (pos = cnt; pos > 0; pos--) {
+		if (cand[pos - 1].rate_err < new->rate_err)
+			break;
+		if ((cand[pos - 1].rate_err == new->rate_err) &&
+		    (!cand[pos - 1].relock || new->relock))
+			break;
+	}
+	if (pos >= num)
+		return cnt;
+
+	if (cnt == num)
+		cnt--;
+	memmove(&cand[pos + 1], &cand[pos], (cnt - pos) * sizeof(*cand));
+	cand[pos] = *new;
+
+	return cnt + 1;
+}
+
+/*
+ * Best input multiplier and divider pairs for output frequency, found in
+ * a single pass over input multipliers giving VCO frequency within allowed
+ * range. Pinned VCO gives current pair only. Other outputs take divider
+ * closest to their requested frequency.
+ * Returns number of candidates, or -EINVAL for frequency out of range.
+ */
+static int logiclk_solve_candidates(struct logiclk_output *output,
+				    u64 freq_out,
+				    struct logiclk_candidate *cand,
+				    unsigned int num)
+{
+	struct logiclk_data *data = output->data;
+	const struct logiclk_limits *limits = &data->limits;
+	struct logiclk_input *input = &data->input;
+	struct logiclk_candidate new;
+	u64 clk_freq_input = input->clk_freq;
+	u64 freq_vco;
+	u32 clkfbout_mult, divclk_divide, clkout_divide, clkout_frac;
+	u32 mult_min, mult_max;
+	unsigned int cnt = 0, i;
+	bool frac = data->frac_divide && (output->id == 0);
+	int j;
+
+	if ((freq_out < limits->output_freq_min) ||
+	    (freq_out > limits->output_freq_max))
+		return -EINVAL;
+
+	memset(cand, 0, num * sizeof(*cand));
+	memset(&new, 0, sizeof(new));
+
+	for (divclk_divide = limits->divclk_divide_min;
+	     divclk_divide <= limits->divclk_divide_max;
+	     divclk_divide++) {
+		if (data->vco_pinned && (divclk_divide != input->divclk_divide))
+			continue;
+		if (!logiclk_mult_range(data, divclk_divide, &mult_min,
+					&mult_max))
+			continue;
+		if (data->vco_pinned) {
+			if ((input->clkfbout_mult < mult_min) ||
+			    (input->clkfbout_mult > mult_max))
+				continue;
+			mult_min = input->clkfbout_mult;
+			mult_max = input->clkfbout_mult;
+		}
+
+		for (clkfbout_mult = mult_min; clkfbout_mult <= mult_max;
+		     clkfbout_mult++) {
+			freq_vco = div_u64(clk_freq_input * clkfbout_mult,
+					   divclk_divide);
+
+			new.clkfbout_mult = clkfbout_mult;
+			new.divclk_divide = divclk_divide;
+			new.vco_rate = (unsigned long)freq_vco;
+			new.rate_err = logiclk_pll_vco_err(freq_vco, freq_out,
+							   frac,
+							   &clkout_divide,
+							   &clkout_frac);
+			new.relock =
+				(clkfbout_mult != input->clkfbout_mult) ||
+				(divclk_divide != input->divclk_divide);
+
+			cnt = logiclk_candidate_insert(cand, cnt, num, &new);
+		}
+	}
+
+	for (i = 0; i < cnt; i++)
+		for (j = 0; j < data->outputs; j++)
+			cand[i].rate[j] = logiclk_pll_output_freq(
+				&data->output[j], cand[i].vco_rate,
+				(j == output->id) ? freq_out :
+				data->output[j].clkout_freq);
+
+	return cnt;
+}
+
+static inline unsigned int logiclk_clkout_reg(unsigned int id)
+{
+	return LOGICLK_PLL_REG_OFF + (id * 2);
+}
+
+/*
+ * Outputs not described in DT keep a valid counter configuration with
+ * maximum divider, and are not recalculated afterwards.
+ */
+static void logiclk_man_reg_params_unused(struct logiclk_data *data)
+{
+	u32 clkout = logiclk_pll_count(MMCM_CLKOUT_DIVIDE_MAX, 50000, 0);
+	unsigned int id;
+
+	for (id = data->outputs; id < LOGICLK_OUTPUTS_MAX; id++) {
+		data->man_regs[logiclk_clkout_reg(id)] =
+			logiclk_get_bits(clkout, 15, 0);
+		data->man_regs[logiclk_clkout_reg(id) + 1] =
+			logiclk_get_bits(clkout, 31, 16);
+	}
+}
+
+static void logiclk_man_reg_params_id(struct logiclk_input *input,
+				      struct logiclk_output *output,
+				      unsigned int id)
+{
+	struct logiclk_data *data = output->data;
+	u64 clkout;
+	u32 *clkout5_reg2 = &data->man_regs[LOGICLK_CLKOUT5_REG2];
+	u32 frac_bits;
+
+	output->clkout_divide = logiclk_pll_output_div(output,
+						       logiclk_calc_vco(data),
+						       output->clkout_freq,
+						       &output->clkout_frac);
+
+	if (output->clkout_frac)
+		clkout = logiclk_pll_frac_count(output->clkout_divide,
+						output->clkout_frac,
+						output->clkout_phase);
+	else
+		clkout = logiclk_pll_count(output->clkout_divide,
+					   output->clkout_duty,
+					   output->clkout_phase);
+
+	/* CLKOUT0 fractional bits are kept over CLKOUT5 changes */
+	frac_bits = *clkout5_reg2 & LOGICLK_CLKOUT0_FRAC_MASK;
+
+	data->man_regs[logiclk_clkout_reg(id)] =
+		logiclk_get_bits(clkout, 15, 0);
+	data->man_regs[logiclk_clkout_reg(id) + 1] =
+		logiclk_get_bits(clkout, 31, 16);
+
+	if (id == 0)
+		frac_bits = logiclk_get_bits(clkout, 35, 32) <<
+			    LOGICLK_CLKOUT0_FRAC_SHIFT;
+	*clkout5_reg2 = (*clkout5_reg2 & ~LOGICLK_CLKOUT0_FRAC_MASK) |
+			frac_bits;
+}
+
+static void logiclk_man_reg_params(struct logiclk_input *input,
+				   struct logiclk_output *output)
+{
+	struct logiclk_data *data = output->data;
+	u64 lock;
+	u32 clkfbout, divclk, filter;
+
+	clkfbout = logiclk_pll_count(input->clkfbout_mult,
+				     output->clkout_duty,
+				     input->clkfbout_phase);
+	divclk = logiclk_pll_count(input->divclk_divide,
+				   output->clkout_duty,
+				   output->clkout_phase);
+
+	filter = logiclk_pll_lut_filter(data->family,
+					(input->clkfbout_mult - 1),
+					input->bw_high);
+
+	lock = logiclk_pll_lut_lock(data->family, input->clkfbout_mult - 1);
+
+	data->man_regs[0] = 0xFFFF;
+
+	data->man_regs[13] = (logiclk_get_bits(divclk, 23, 22) << 12) |
+			     (logiclk_get_bits(divclk, 11, 0) << 0);
+	data->man_regs[14] = logiclk_get_bits(clkfbout, 15, 0);
+	data->man_regs[15] = logiclk_get_bits(clkfbout, 31, 16);
+	data->man_regs[16] = logiclk_get_bits(lock, 29, 20);
+	data->man_regs[17] = (logiclk_get_bits(lock, 34, 30) << 10) |
+			     logiclk_get_bits(lock, 9, 0);
+	data->man_regs[18] = (logiclk_get_bits(lock, 39, 35) << 10) |
+			     logiclk_get_bits(lock, 19, 10);
+	data->man_regs[19] = (logiclk_get_bits(filter, 6, 6) << 8)  |
+			     (logiclk_get_bits(filter, 8, 7) << 11) |
+			     (logiclk_get_bits(filter, 9, 9) << 15);
+	data->man_regs[20] = (logiclk_get_bits(filter, 0, 0) << 4)  |
+			     (logiclk_get_bits(filter, 2, 1) << 7)  |
+			     (logiclk_get_bits(filter, 4, 3) << 11) |
+			     (logiclk_get_bits(filter, 5, 5) << 15);
+}
+
+/*
+ * Recalculate all output parameters with current input multiplier and
+ * divider. Every output keeps the divider closest to its requested frequency.
+ */
+static void logiclk_calc_outputs(struct logiclk_data *data)
+{
+	struct logiclk_input *input = &data->input;
+	int i;
+
+	logiclk_man_reg_params(input, data->precise);
+	for (i = 0; i < data->outputs; i++)
+		logiclk_man_reg_params_id(input, &data->output[i],
+					  data->output[i].id);
+}
+
+static int logiclk_calc_params(struct logiclk_output *output)
+{
+	struct logiclk_data *data = output->data;
+	const struct logiclk_limits *limits = &data->limits;
+	struct logiclk_input *input = &data->input;
+	struct device *dev = data->dev;
+	struct logiclk_solution sol;
+
+	if ((output->clkout_freq < limits->output_freq_min) ||
+	    (output->clkout_freq > limits->output_freq_max)) {
+		dev_err(dev, "invalid output frequency %u Hz\n",
+			output->clkout_freq);
+		return -EINVAL;
+	}
+
+	if (output->precise) {
+		if (!data->vco_pinned &&
+		    !logiclk_pll_input_keep(output, output->clkout_freq,
+					    &sol)) {
+			input->clkfbout_mult = sol.clkfbout_mult;
+			input->divclk_divide = sol.divclk_divide;
+		}
+		logiclk_calc_outputs(data);
+	} else {
+		logiclk_man_reg_params_id(input, output, output->id);
+	}
+
+	return 0;
+}
+
+static inline bool logiclk_hw_locked(struct logiclk_data *data)
+{
+	unsigned int val;
+
+	if (regmap_read(data->regmap, LOGICLK_PLL_REG, &val))
+		return false;
+
+	return val & LOGICLK_PLL_LOCK;
+}
+
+static int logiclk_hw_poll_lock(struct logiclk_data *data)
+{
+	unsigned int val;
+
+	return regmap_read_poll_timeout(data->regmap, LOGICLK_PLL_REG, val,
+					val & LOGICLK_PLL_LOCK,
+					PLL_LOCK_SLEEP_US, PLL_LOCK_TIMEOUT_US);
+}
+
+/*
+ * With lock status interrupt, lock is signaled as soon as it is reached,
+ * without sleeping in polling intervals.
+ */
+static int logiclk_hw_wait_lock(struct logiclk_data *data)
+{
+	unsigned long timeout = usecs_to_jiffies(PLL_LOCK_TIMEOUT_US);
+	int ret = 0;
+
+	if (data->irq && data->monitored) {
+		reinit_completion(&data->locked);
+		if (!logiclk_hw_locked(data) &&
+		    !wait_for_completion_timeout(&data->locked, timeout) &&
+		    !logiclk_hw_locked(data))
+			ret = -ETIMEDOUT;
+	} else {
+		ret = logiclk_hw_poll_lock(data);
+	}
+
+	if (ret)
+		dev_err(data->dev, "failed pll lock\n");
+
+	return ret;
+}
+
+/*
+ * Configuration command holds MMCM in reset while it is reconfigured, so
+ * lock drops within microseconds and is busy polled for. Lock status read
+ * before the drop still belongs to previous configuration, so lock is
+ * waited for only after it dropped. Lock status interrupt thread passes
+ * @poll, as it can not wait for itself. Lock time covers both the drop and
+ * the relock.
+ */
+static int logiclk_hw_relock(struct logiclk_data *data, u32 cfg, bool poll)
+{
+	ktime_t start = ktime_get();
+	unsigned int val;
+	int ret;
+
+	regmap_write(data->regmap, LOGICLK_PLL_REG, cfg);
+
+	ret = regmap_read_poll_timeout(data->regmap, LOGICLK_PLL_REG, val,
+				       !(val & LOGICLK_PLL_LOCK), 0,
+				       PLL_UNLOCK_TIMEOUT_US);
+	if (ret) {
+		dev_err(data->dev, "failed pll reconfiguration\n");
+		return ret;
+	}
+
+	if (poll)
+		ret = logiclk_hw_poll_lock(data);
+	else
+		ret = logiclk_hw_wait_lock(data);
+
+	data->lock_time = ktime_to_us(ktime_sub(ktime_get(), start));
+	dev_dbg(data->dev, "pll relock %s, %u us\n",
+		(!poll && data->irq && data->monitored) ? "irq" : "poll",
+		data->lock_time);
+
+	return ret;
+}
+
+/*
+ * Write committed manual registers and return configuration command. Only
+ * registers differing from register cache are written.
+ */
+static u32 logiclk_hw_write(struct logiclk_data *data)
+{
+	int i;
+
+	if (!data->hw_regs_num)
+		return LOGICLK_PLL_CONFIG;
+
+	for (i = 0; i < data->hw_regs_num; i++)
+		regmap_update_bits(data->regmap, LOGICLK_MAN_REG(i), ~0U,
+				   data->hw_regs[i]);
+
+	return LOGICLK_PLL_CONFIG | LOGICLK_PLL_CONFIG_SW;
+}
+
+/*
+ * Write all committed manual registers differing from hw defaults, when hw
+ * registers may not match register cache.
+ */
+static u32 logiclk_hw_sync(struct logiclk_data *data)
+{
+	u32 cfg;
+
+	regcache_cache_only(data->regmap, true);
+	cfg = logiclk_hw_write(data);
+	regcache_cache_only(data->regmap, false);
+
+	regcache_mark_dirty(data->regmap);
+	regcache_sync(data->regmap);
+
+	return cfg;
+}
+
+/*
+ * Program active registers. Register cache holds hw values, also of a
+ * register map created after the image was committed, so only registers
+ * which differ from programmed ones are written.
+ */
+static int logiclk_hw_program(struct logiclk_data *data)
+{
+	u32 cfg;
+	int ret;
+
+	cfg = logiclk_hw_write(data);
+
+	ret = logiclk_hw_wait_lock(data);
+	if (ret)
+		return ret;
+
+	return logiclk_hw_relock(data, cfg, false);
+}
+
+/*
+ * Program active registers after configuration failed to lock. MMCM stays
+ * unlocked with failed configuration, so lock is not waited for before
+ * configuration command.
+ */
+static int logiclk_hw_rollback(struct logiclk_data *data)
+{
+	return logiclk_hw_relock(data, logiclk_hw_write(data), false);
+}
+
+/*
+ * Staged registers become active and previously active ones are kept until
+ * lock. Configuration failing to lock is replaced with previously committed
+ * one, so outputs are down for one extra lock cycle only. Called with
+ * cfg_lock held.
+ */
+static int logiclk_hw_config(struct logiclk_data *data)
+{
+	u32 *prev_regs;
+	int prev_regs_num;
+	int ret = 0;
+
+	mutex_lock(&data->hw_lock);
+
+	prev_regs = data->hw_regs;
+	prev_regs_num = data->hw_regs_num;
+
+	data->hw_regs = data->man_regs;
+	data->man_regs = prev_regs;
+	data->hw_regs_num = LOGICLK_MANUAL_REGS;
+	data->commits++;
+
+	/*
+	 * Powered down MMCM is programmed from cached registers on wake, early
+	 * registered one when platform device takes over.
+	 */
+	if (data->powered_down || !data->regmap)
+		goto out;
+
+	ret = logiclk_hw_program(data);
+	if (ret) {
+		data->commit_failed++;
+		dev_err(data->dev, "failed configuration, restoring previous\n");
+
+		data->man_regs = data->hw_regs;
+		data->hw_regs = prev_regs;
+		data->hw_regs_num = prev_regs_num;
+		if (logiclk_hw_rollback(data))
+			dev_err(data->dev,
+				"failed restore previous configuration\n");
+	}
+
+out:
+	/*
+	 * Next configuration is staged over active one. Hw configuration has
+	 * no register image, failed one is kept and encoded again by caller.
+	 */
+	if (data->hw_regs_num)
+		memcpy(data->man_regs, data->hw_regs, sizeof(data->regs[0]));
+
+	mutex_unlock(&data->hw_lock);
+
+	return ret;
+}
+
+/*
+ * Lock lost at runtime, for example on input clock glitch. Last committed
+ * configuration is programmed again without solving anything.
+ */
+static void logiclk_lock_restore(struct logiclk_data *data)
+{
+	struct device *dev = data->dev;
+
+	/* relock in progress is waited for by configuration itself */
+	if (!mutex_trylock(&data->hw_lock))
+		return;
+
+	if (logiclk_hw_locked(data)) {
+		mutex_unlock(&data->hw_lock);
+		return;
+	}
+
+	data->lock_lost++;
+	dev_warn(dev, "pll lock lost, restoring configuration\n");
+
+	if (logiclk_hw_relock(data, logiclk_hw_sync(data), true))
+		dev_err(dev, "failed pll lock\n");
+
+	mutex_unlock(&data->hw_lock);
+
+	sysfs_notify(&dev->kobj, NULL, "lock_lost");
+}
+
+/*
+ * Program committed registers again, without solving anything. Called with
+ * hw lock held.
+ */
+static int logiclk_hw_replay(struct logiclk_data *data)
+{
+	return logiclk_hw_relock(data, logiclk_hw_sync(data), false);
+}
+
+static void logiclk_power_down(struct logiclk_data *data)
+{
+	mutex_lock(&data->hw_lock);
+	if (reset_control_assert(data->pwrdn))
+		dev_warn(data->dev, "failed power down\n");
+	else
+		data->powered_down = true;
+	mutex_unlock(&data->hw_lock);
+}
+
+/* Called with hw lock held */
+static int logiclk_power_up(struct logiclk_data *data)
+{
+	int ret;
+
+	ret = reset_control_deassert(data->pwrdn);
+	if (ret) {
+		dev_err(data->dev, "failed power up\n");
+		return ret;
+	}
+	data->powered_down = false;
+
+	if (!completion_done(&data->configured))
+		return 0;
+
+	return logiclk_hw_replay(data);
+}
+
+static irqreturn_t logiclk_lock_irq(int irq, void *dev_id)
+{
+	struct logiclk_data *data = dev_id;
+
+	if (logiclk_hw_locked(data))
+		complete(&data->locked);
+	else
+		logiclk_lock_restore(data);
+
+	return IRQ_HANDLED;
+}
+
+static void logiclk_lock_poll(struct work_struct *work)
+{
+	struct logiclk_data *data = container_of(to_delayed_work(work),
+						 struct logiclk_data,
+						 lock_monitor);
+
+	logiclk_lock_restore(data);
+
+	schedule_delayed_work(&data->lock_monitor,
+			      msecs_to_jiffies(PLL_LOCK_POLL_MS));
+}
+
+static void logiclk_lock_monitor_start(struct logiclk_data *data)
+{
+	if (data->irq)
+		enable_irq(data->irq);
+	else
+		schedule_delayed_work(&data->lock_monitor,
+				      msecs_to_jiffies(PLL_LOCK_POLL_MS));
+	data->monitored = true;
+}
+
+static void logiclk_lock_monitor_stop(struct logiclk_data *data)
+{
+	data->monitored = false;
+	if (data->irq)
+		disable_irq(data->irq);
+	else
+		cancel_delayed_work_sync(&data->lock_monitor);
+}
+
+static void logiclk_state_save(struct logiclk_data *data)
+{
+	struct logiclk_state *state = &data->committed;
+	int i;
+
+	state->input = data->input;
+	for (i = 0; i < data->outputs; i++) {
+		state->clkout_freq[i] = data->output[i].clkout_freq;
+		state->clkout_divide[i] = data->output[i].clkout_divide;
+		state->clkout_frac[i] = data->output[i].clkout_frac;
+	}
+	state->valid = true;
+}
+
+/*
+ * Hw configuration from DT is committed state until initial configuration
+ * locks, outputs run from DT dividers whatever frequency is requested.
+ */
+static void logiclk_state_save_of(struct logiclk_data *data)
+{
+	struct logiclk_state *state = &data->committed;
+	int i;
+
+	logiclk_state_save(data);
+	for (i = 0; i < data->outputs; i++)
+		state->clkout_freq[i] = logiclk_calc_freq(&data->output[i]);
+}
+
+/* Parameters follow hw rolled back to last committed configuration */
+static void logiclk_state_restore(struct logiclk_data *data)
+{
+	struct logiclk_state *state = &data->committed;
+	u32 clk_freq = data->input.clk_freq;
+	int i;
+
+	if (!state->valid)
+		return;
+
+	/*
+	 * Input clock frequency follows input clock, rolled back
+	 * configuration runs from the new input frequency.
+	 */
+	data->input = state->input;
+	data->input.clk_freq = clk_freq;
+	for (i = 0; i < data->outputs; i++) {
+		data->output[i].clkout_freq = state->clkout_freq[i];
+		data->output[i].clkout_divide = state->clkout_divide[i];
+		data->output[i].clkout_frac = state->clkout_frac[i];
+	}
+	data->pending.vco_freq = 0;
+}
+
+/*
+ * Commit register image. First commit also completes initial configuration,
+ * with any rate change made before it merged in. On failure, parameters are
+ * rolled back with hw, and staged registers are encoded from them if hw was
+ * rolled back to hw configuration. Early registered clocks only stage
+ * commits, hw keeps running hw configuration saved at early init.
+ */
+static int logiclk_hw_commit(struct logiclk_data *data)
+{
+	int ret;
+
+	ret = logiclk_hw_config(data);
+	if (ret) {
+		logiclk_state_restore(data);
+		if (!data->hw_regs_num)
+			logiclk_calc_outputs(data);
+	} else if (data->regmap) {
+		logiclk_state_save(data);
+	}
+
+	/* failed initial configuration is cleared by later commit */
+	if (!completion_done(&data->configured)) {
+		data->config_err = ret;
+		complete_all(&data->configured);
+	} else if (!ret) {
+		data->config_err = 0;
+	}
+
+	return ret;
+}
+
+/*
+ * Initial configuration solved in probe is programmed asynchronously, so
+ * several devices lock in parallel and only consumers preparing output
+ * clocks wait for it.
+ *
+ * It replaces hw configuration, which is restored without register image
+ * if it fails to lock. Staged registers are therefore released as soon as
+ * the image is taken, and rate changes are solved and staged over it while
+ * it locks. Configuration committed meanwhile supersedes the initial one.
+ */
+static void logiclk_config_work(struct work_struct *work)
+{
+	struct logiclk_data *data = container_of(work, struct logiclk_data,
+						 config_work);
+	u32 commits;
+	int ret = 0;
+
+	mutex_lock(&data->cfg_lock);
+
+	/* committed meanwhile by first prepare or rate change */
+	if (completion_done(&data->configured)) {
+		mutex_unlock(&data->cfg_lock);
+		return;
+	}
+
+	mutex_lock(&data->hw_lock);
+	swap(data->hw_regs, data->man_regs);
+	data->hw_regs_num = LOGICLK_MANUAL_REGS;
+	memcpy(data->man_regs, data->hw_regs, sizeof(data->regs[0]));
+	commits = ++data->commits;
+	mutex_unlock(&data->cfg_lock);
+
+	if (!data->powered_down && data->regmap) {
+		ret = logiclk_hw_program(data);
+		if (ret) {
+			data->commit_failed++;
+			dev_err(data->dev,
+				"failed configuration, restoring hw configuration\n");
+
+			data->hw_regs_num = 0;
+			if (logiclk_hw_rollback(data))
+				dev_err(data->dev,
+					"failed restore hw configuration\n");
+		}
+	}
+	mutex_unlock(&data->hw_lock);
+
+	mutex_lock(&data->cfg_lock);
+	if (commits == data->commits) {
+		if (ret) {
+			logiclk_state_restore(data);
+			logiclk_calc_outputs(data);
+		} else {
+			logiclk_state_save(data);
+		}
+	}
+
+	if (!completion_done(&data->configured)) {
+		data->config_err = ret;
+		complete_all(&data->configured);
+	}
+	mutex_unlock(&data->cfg_lock);
+}
+
+/*
+ * Solve precise output again for new input clock frequency. Current input
+ * multiplier and divider are kept if no solution is found.
+ */
+static void logiclk_input_solve(struct logiclk_data *data, u32 clk_freq)
+{
+	struct logiclk_input *input = &data->input;
+	struct logiclk_pending *pending = &data->pending;
+	struct logiclk_output *precise = data->precise;
+	struct logiclk_solution sol;
+	u32 clk_freq_cur = input->clk_freq;
+	int ret;
+
+	if (pending->vco_freq && (pending->clk_freq == clk_freq))
+		return;
+
+	/* solvers take input frequency from input parameters */
+	input->clk_freq = clk_freq;
+	ret = logiclk_pll_input_mult_div(precise, precise->clkout_freq, &sol);
+	input->clk_freq = clk_freq_cur;
+
+	if (ret) {
+		sol.clkfbout_mult = input->clkfbout_mult;
+		sol.divclk_divide = input->divclk_divide;
+	}
+
+	pending->clk_freq = clk_freq;
+	pending->clkfbout_mult = sol.clkfbout_mult;
+	pending->divclk_divide = sol.divclk_divide;
+	pending->clkout_freq = precise->clkout_freq;
+	pending->vco_freq = div_u64((u64)clk_freq * sol.clkfbout_mult,
+				    sol.divclk_divide);
+}
+
+/* Input clock changed, all outputs are recalculated with single commit */
+static int logiclk_input_change(struct logiclk_data *data, u32 clk_freq)
+{
+	struct logiclk_input *input = &data->input;
+	struct logiclk_pending *pending = &data->pending;
+	int ret;
+
+	mutex_lock(&data->cfg_lock);
+	logiclk_input_solve(data, clk_freq);
+
+	input->clk_freq = clk_freq;
+	input->clkfbout_mult = pending->clkfbout_mult;
+	input->divclk_divide = pending->divclk_divide;
+	pending->vco_freq = 0;
+	logiclk_calc_outputs(data);
+
+	ret = logiclk_hw_commit(data);
+	mutex_unlock(&data->cfg_lock);
+
+	return ret;
+}
+
+static int logiclk_input_notifier_cb(struct notifier_block *nb,
+				     unsigned long event, void *ptr)
+{
+	struct logiclk_data *data = to_logiclk_data_nb(nb);
+	const struct logiclk_limits *limits = &data->limits;
+	struct clk_notifier_data *ndata = ptr;
+
+	switch (event) {
+	case PRE_RATE_CHANGE:
+		if (data->vco_pinned ||
+		    (ndata->new_rate < limits->input_freq_min) ||
+		    (ndata->new_rate > limits->input_freq_max))
+			return NOTIFY_BAD;
+		return NOTIFY_OK;
+	case POST_RATE_CHANGE:
+		if (ndata->new_rate == data->input.clk_freq)
+			return NOTIFY_OK;
+		return notifier_from_errno(logiclk_input_change(data,
+							ndata->new_rate));
+	default:
+		return NOTIFY_DONE;
+	}
+}
+
+static unsigned long __logiclk_vco_recalc_rate(struct logiclk_data *data,
+					       unsigned long parent_rate)
+{
+	/*
+	 * Instead IO access, take parameters from struct logiclk_data.
+	 * The same parameters are set in logiCLK hw registers.
+	 */
+	if (!data->clk_in || (parent_rate == data->input.clk_freq))
+		return (unsigned long)logiclk_calc_vco(data);
+
+	/*
+	 * Input clock rate change, give VCO frequency which input notifier
+	 * sets with the same solution.
+	 */
+	logiclk_input_solve(data, parent_rate);
+
+	return (unsigned long)data->pending.vco_freq;
+}
+
+static unsigned long logiclk_vco_recalc_rate(struct clk_hw *hw,
+					     unsigned long parent_rate)
+{
+	struct logiclk_data *data = to_logiclk_data(hw);
+	unsigned long rate;
+
+	mutex_lock(&data->cfg_lock);
+	rate = __logiclk_vco_recalc_rate(data, parent_rate);
+	mutex_unlock(&data->cfg_lock);
+
+	return rate;
+}
+
+static long __logiclk_vco_round_rate(struct logiclk_data *data,
+				     unsigned long rate)
+{
+	u32 clkfbout_mult, divclk_divide;
+	u64 freq_vco;
+
+	if (data->vco_pinned)
+		return (long)logiclk_calc_vco(data);
+
+	freq_vco = logiclk_pll_vco_mult_div(data, rate, &clkfbout_mult,
+					    &divclk_divide);
+	if (!freq_vco)
+		return -EINVAL;
+
+	return (long)freq_vco;
+}
+
+static long logiclk_vco_round_rate(struct clk_hw *hw, unsigned long rate,
+				   unsigned long *parent_rate)
+{
+	struct logiclk_data *data = to_logiclk_data(hw);
+	long ret;
+
+	mutex_lock(&data->cfg_lock);
+	ret = __logiclk_vco_round_rate(data, rate);
+	mutex_unlock(&data->cfg_lock);
+
+	return ret;
+}
+
+static int __logiclk_vco_set_rate(struct logiclk_data *data,
+				  unsigned long rate)
+{
+	struct logiclk_pending *pending = &data->pending;
+	struct logiclk_input *input = &data->input;
+	u32 clkfbout_mult, divclk_divide;
+
+	/* VCO already set, e.g. by input clock notifier */
+	if (rate == logiclk_calc_vco(data))
+		return 0;
+
+	if (data->vco_pinned)
+		return -EBUSY;
+
+	/*
+	 * VCO change requested by precise output takes solved multiplier and
+	 * divider, others take the closest VCO frequency within limits.
+	 */
+	if (pending->vco_freq && (pending->vco_freq == rate) &&
+	    (pending->clk_freq == input->clk_freq)) {
+		clkfbout_mult = pending->clkfbout_mult;
+		divclk_divide = pending->divclk_divide;
+		data->precise->clkout_freq = pending->clkout_freq;
+	} else if (!logiclk_pll_vco_mult_div(data, rate, &clkfbout_mult,
+					     &divclk_divide)) {
+		return -EINVAL;
+	}
+	pending->vco_freq = 0;
+
+	input->clkfbout_mult = clkfbout_mult;
+	input->divclk_divide = divclk_divide;
+	logiclk_calc_outputs(data);
+
+	return logiclk_hw_commit(data);
+}
+
+static int logiclk_vco_set_rate(struct clk_hw *hw, unsigned long rate,
+				unsigned long parent_rate)
+{
+	struct logiclk_data *data = to_logiclk_data(hw);
+	int ret;
+
+	mutex_lock(&data->cfg_lock);
+	ret = __logiclk_vco_set_rate(data, rate);
+	mutex_unlock(&data->cfg_lock);
+
+	return ret;
+}
+
+static const struct clk_ops logiclk_vco_ops = {
+	.recalc_rate = logiclk_vco_recalc_rate,
+	.round_rate = logiclk_vco_round_rate,
+	.set_rate = logiclk_vco_set_rate,
+};
+
+static unsigned long logiclk_recalc_rate(struct clk_hw *hw,
+					 unsigned long parent_rate)
+{
+	struct logiclk_output *output = to_logiclk_output(hw);
+
+	return (unsigned long)logiclk_pll_output_freq(output, parent_rate,
+						      output->clkout_freq);
+}
+
+static long __logiclk_round_rate(struct logiclk_output *output,
+				 unsigned long rate, unsigned long *parent_rate)
+{
+	struct logiclk_data *data = output->data;
+	const struct logiclk_limits *limits = &data->limits;
+	struct logiclk_pending *pending = &data->pending;
+	struct logiclk_solution sol;
+	u64 freq_vco;
+	u32 freq_out;
+
+	if ((rate < limits->output_freq_min) ||
+	    (rate > limits->output_freq_max))
+		return -EINVAL;
+
+	/* pinned VCO gives only output divider change within tolerance */
+	if (data->vco_pinned) {
+		freq_out = logiclk_pll_output_freq(output, *parent_rate, rate);
+		if (abs((s64)freq_out - (s64)rate) >
+		    logiclk_freq_tol(data, rate))
+			return -EINVAL;
+		return (long)freq_out;
+	}
+
+	/* VCO is changed only if precise output misses tolerance */
+	if (!output->precise || logiclk_pll_input_keep(output, rate, &sol))
+		return (long)logiclk_pll_output_freq(output, *parent_rate,
+						     rate);
+
+	freq_vco = div_u64((u64)data->input.clk_freq * sol.clkfbout_mult,
+			   sol.divclk_divide);
+
+	pending->vco_freq = freq_vco;
+	pending->clk_freq = data->input.clk_freq;
+	pending->clkfbout_mult = sol.clkfbout_mult;
+	pending->divclk_divide = sol.divclk_divide;
+	pending->clkout_freq = rate;
+
+	*parent_rate = (unsigned long)freq_vco;
+
+	return (long)logiclk_pll_output_freq(output, freq_vco, rate);
+}
+
+static long logiclk_round_rate(struct clk_hw *hw, unsigned long rate,
+			       unsigned long *parent_rate)
+{
+	struct logiclk_output *output = to_logiclk_output(hw);
+	struct logiclk_data *data = output->data;
+	long ret;
+
+	mutex_lock(&data->cfg_lock);
+	ret = __logiclk_round_rate(output, rate, parent_rate);
+	mutex_unlock(&data->cfg_lock);
+
+	return ret;
+}
+
+static int __logiclk_set_rate(struct logiclk_output *output,
+			      unsigned long rate, unsigned long parent_rate)
+{
+	struct logiclk_data *data = output->data;
+
+	if (output->precise)
+		data->pending.vco_freq = 0;
+
+	/* early registered output keeps consumer rate on device attach */
+	if (data->early && !data->dev)
+		output->rate_set = true;
+
+	/* divider already set by VCO rate change */
+	if (rate == logiclk_recalc_rate(&output->hw, parent_rate))
+		return 0;
+
+	output->clkout_freq = rate;
+	logiclk_man_reg_params_id(&data->input, output, output->id);
+
+	return logiclk_hw_commit(data);
+}
+
+static int logiclk_set_rate(struct clk_hw *hw, unsigned long rate,
+			    unsigned long parent_rate)
+{
+	struct logiclk_output *output = to_logiclk_output(hw);
+	struct logiclk_data *data = output->data;
+	int ret;
+
+	mutex_lock(&data->cfg_lock);
+	ret = __logiclk_set_rate(output, rate, parent_rate);
+	mutex_unlock(&data->cfg_lock);
+
+	return ret;
+}
+
+/*
+ * Device is runtime active while any output is prepared. Outputs prepared
+ * before device attach are counted, and taken over by attach.
+ */
+static int logiclk_runtime_get(struct logiclk_data *data)
+{
+	int ret;
+
+	if (data->prepared++ || !data->dev)
+		return 0;
+
+	ret = pm_runtime_get_sync(data->dev);
+	if (ret < 0) {
+		pm_runtime_put_noidle(data->dev);
+		data->prepared--;
+		return ret;
+	}
+
+	return 0;
+}
+
+static void logiclk_runtime_put(struct logiclk_data *data)
+{
+	if (--data->prepared || !data->dev)
+		return;
+
+	pm_runtime_put(data->dev);
+}
+
+static int logiclk_prepare(struct clk_hw *hw)
+{
+	struct logiclk_output *output = to_logiclk_output(hw);
+	struct logiclk_data *data = output->data;
+	int ret;
+
+	ret = logiclk_runtime_get(data);
+	if (ret)
+		return ret;
+
+	/* deferred initial configuration is committed by first consumer */
+	mutex_lock(&data->cfg_lock);
+	if (data->deferred && !completion_done(&data->configured))
+		logiclk_hw_commit(data);
+	mutex_unlock(&data->cfg_lock);
+
+	wait_for_completion(&data->configured);
+
+	if (data->config_err)
+		logiclk_runtime_put(data);
+
+	return data->config_err;
+}
+
+static void logiclk_unprepare(struct clk_hw *hw)
+{
+	struct logiclk_output *output = to_logiclk_output(hw);
+
+	logiclk_runtime_put(output->data);
+}
+
+static const struct clk_ops logiclk_clk_ops = {
+	.prepare = logiclk_prepare,
+	.unprepare = logiclk_unprepare,
+	.recalc_rate = logiclk_recalc_rate,
+	.round_rate = logiclk_round_rate,
+	.set_rate = logiclk_set_rate,
+};
+
+/* Early registered data has no device and is never freed */
+static void *logiclk_alloc(struct logiclk_data *data, size_t size)
+{
+	if (data->dev)
+		return devm_kzalloc(data->dev, size, GFP_KERNEL);
+
+	return kzalloc(size, GFP_KERNEL);
+}
+
+/*
+ * Speed grade limits given as <min max> pair may only narrow device family
+ * limits. Narrower VCO range shrinks the solver search space and avoids
+ * configurations which device cannot lock.
+ */
+static int logiclk_get_of_range(struct device_node *dn, const char *name,
+				struct logiclk_data *data, u64 *min, u64 *max)
+{
+	struct device *dev = data->dev;
+	u32 range[2];
+
+	if (of_property_read_u32_array(dn, name, range, 2))
+		return 0;
+
+	if ((range[0] < *min) || (range[1] > *max) || (range[0] > range[1])) {
+		dev_err(dev, "invalid %s\n", name);
+		return -EINVAL;
+	}
+
+	*min = range[0];
+	*max = range[1];
+
+	return 0;
+}
+
+static int logiclk_get_of_limits(struct device_node *dn,
+				 struct logiclk_data *data)
+{
+	struct logiclk_limits *limits = &data->limits;
+	u64 min, max;
+	int err;
+
+	min = limits->input_freq_min;
+	max = limits->input_freq_max;
+	err = logiclk_get_of_range(dn, "input-frequency-range", data,
+				   &min, &max);
+	if (err)
+		return err;
+	limits->input_freq_min = min;
+	limits->input_freq_max = max;
+
+	min = limits->output_freq_min;
+	max = limits->output_freq_max;
+	err = logiclk_get_of_range(dn, "output-frequency-range", data,
+				   &min, &max);
+	if (err)
+		return err;
+	limits->output_freq_min = min;
+	limits->output_freq_max = max;
+
+	return logiclk_get_of_range(dn, "vco-frequency-range", data,
+				    &limits->vco_freq_min,
+				    &limits->vco_freq_max);
+}
+
+static int logiclk_get_of_solver(struct device_node *dn,
+				 struct logiclk_data *data)
+{
+	const struct logiclk_limits *limits = &data->limits;
+	struct device *dev = data->dev;
+	const char *name;
+	int i, err, len;
+
+	if (of_property_read_string(dn, "solver", &name))
+		name = solver_name ? solver_name : LOGICLK_SOLVER_DEFAULT;
+
+	data->solver = logiclk_get_solver(name);
+	if (!data->solver) {
+		dev_err(dev, "invalid solver %s\n", name);
+		return -EINVAL;
+	}
+
+	if (of_property_read_u32(dn, "solver-budget", &data->solver_budget))
+		data->solver_budget = solver_budget;
+
+	of_property_read_u32(dn, "precise-tolerance", &data->tolerance);
+	if (data->tolerance > LOGICLK_TOLERANCE_MAX) {
+		dev_err(dev, "invalid precise-tolerance\n");
+		return -EINVAL;
+	}
+
+	len = of_property_count_u32_elems(dn, "solver-table");
+	if (len <= 0) {
+		if (data->solver->solve == logiclk_solve_table) {
+			dev_warn(dev, "missing solver-table, using %s solver\n",
+				 LOGICLK_SOLVER_DEFAULT);
+			data->solver =
+				logiclk_get_solver(LOGICLK_SOLVER_DEFAULT);
+		}
+		return 0;
+	}
+	if (len % 2) {
+		dev_err(dev, "invalid solver-table\n");
+		return -EINVAL;
+	}
+
+	data->solver_table = logiclk_alloc(data, len * sizeof(u32));
+	if (!data->solver_table)
+		return -ENOMEM;
+
+	err = of_property_read_u32_array(dn, "solver-table", data->solver_table,
+					 len);
+	if (err) {
+		dev_err(dev, "failed get solver-table\n");
+		return err;
+	}
+
+	for (i = 0; i < len; i += 2) {
+		if ((data->solver_table[i] < limits->fbout_multiply_min) ||
+		    (data->solver_table[i] > limits->fbout_multiply_max) ||
+		    (data->solver_table[i + 1] < limits->divclk_divide_min) ||
+		    (data->solver_table[i + 1] > limits->divclk_divide_max)) {
+			dev_err(dev, "invalid solver-table entry %d\n", i / 2);
+			return -EINVAL;
+		}
+	}
+	data->solver_table_len = len / 2;
+
+	return 0;
+}
+
+static int logiclk_get_of_config(struct device_node *dn,
+				 struct logiclk_data *data, bool *set_freq)
+{
+	const struct logiclk_limits *limits = &data->limits;
+	struct device *dev = data->dev;
+	struct device_node *output_dn = NULL;
+	struct logiclk_input *input = &data->input;
+	struct logiclk_output *output;
+	struct device_node *precise_dn;
+	int i, err, outputs;
+
+	outputs = of_get_child_count(dn);
+	if ((outputs < LOGICLK_OUTPUTS_MIN) ||
+	    (outputs > LOGICLK_OUTPUTS_MAX)) {
+		dev_err(dev, "invalid outputs number\n");
+		return -EINVAL;
+	}
+
+	output = logiclk_alloc(data, outputs * sizeof(*output));
+	if (!output)
+		return -ENOMEM;
+
+	data->output = output;
+	data->outputs = outputs;
+	logiclk_man_reg_params_unused(data);
+
+	err = logiclk_get_of_limits(dn, data);
+	if (err)
+		return err;
+
+	if (data->clk_in) {
+		input->clk_freq = clk_get_rate(data->clk_in);
+	} else {
+		err = of_property_read_u32(dn, "input-frequency",
+					   &input->clk_freq);
+		if (err) {
+			dev_err(dev, "failed get input-frequency\n");
+			return err;
+		}
+	}
+	if ((input->clk_freq < limits->input_freq_min) ||
+	    (input->clk_freq > limits->input_freq_max)) {
+		dev_err(dev, "invalid input frequency\n");
+		return -EINVAL;
+	}
+
+	err = of_property_read_u32(dn, "input-divide", &input->divclk_divide);
+	if (err) {
+		dev_err(dev, "failed get input-divide\n");
+		return err;
+	}
+	if ((input->divclk_divide < limits->divclk_divide_min) ||
+	    (input->divclk_divide > limits->divclk_divide_max)) {
+		dev_err(dev, "invalid input divide\n");
+		return -EINVAL;
+	}
+
+	err = of_property_read_u32(dn, "input-multiply", &input->clkfbout_mult);
+	if (err) {
+		dev_err(dev, "failed get input-multiply\n");
+		return err;
+	}
+	if ((input->clkfbout_mult < limits->fbout_multiply_min) ||
+	    (input->clkfbout_mult > limits->fbout_multiply_max)) {
+		dev_err(dev, "invalid input multiply\n");
+		return -EINVAL;
+	}
+	/* initial VCO within limits narrowed by speed grade or DT range */
+	if (!logiclk_vco_valid(data, logiclk_calc_vco(data))) {
+		dev_err(dev, "invalid VCO frequency %llu Hz\n",
+			logiclk_calc_vco(data));
+		return -EINVAL;
+	}
+
+	err = of_property_read_u32(dn, "input-phase", &input->clkfbout_phase);
+	if (err) {
+		dev_err(dev, "failed get input-phase\n");
+		return err;
+	}
+	if (((s32)input->clkfbout_phase < MMCM_FBOUT_PHASE_MIN) ||
+	    (input->clkfbout_phase > MMCM_FBOUT_PHASE_MAX)) {
+		dev_err(dev, "invalid input phase\n");
+		return -EINVAL;
+	}
+
+	if (of_property_read_bool(dn, "bandwidth-high"))
+		input->bw_high = true;
+
+	if (of_property_read_bool(dn, "fractional-divide"))
+		data->frac_divide = true;
+
+	if (of_property_read_bool(dn, "vco-pinned"))
+		data->vco_pinned = true;
+
+	if (of_property_read_bool(dn, "deferred-config"))
+		data->deferred = true;
+
+	err = logiclk_get_of_solver(dn, data);
+	if (err)
+		return err;
+
+	precise_dn = of_parse_phandle(dn, "precise-output", 0);
+	if (!precise_dn) {
+		dev_err(dev, "failed get precise-output\n");
+		return -EINVAL;
+	}
+
+	for (i = 0; i < outputs; i++) {
+		output_dn = of_get_next_child(dn, output_dn);
+		if (!output_dn)
+			break;
+
+		output[i].dn = output_dn;
+		output[i].data = data;
+		output[i].id = i;
+
+		if (output_dn == precise_dn) {
+			output[i].precise = true;
+			data->precise = &output[i];
+		}
+
+		of_property_read_u32(output_dn, "frequency",
+				     &output[i].clkout_freq);
+		if ((output[i].clkout_freq != 0) &&
+		    ((output[i].clkout_freq < limits->output_freq_min) ||
+		    (output[i].clkout_freq > limits->output_freq_max))) {
+			dev_warn(dev, "unsupported output frequency\n");
+			output[i].clkout_freq = 0;
+		}
+		if (output[i].clkout_freq != 0)
+			*set_freq = true;
+
+		err = of_property_read_u32(output_dn, "divide",
+					   &output[i].clkout_divide);
+		if (err) {
+			dev_err(dev, "failed get output %d divide\n", i);
+			goto clk_node_err;
+		}
+		if ((output[i].clkout_divide < MMCM_CLKOUT_DIVIDE_MIN) ||
+		    (output[i].clkout_divide > MMCM_CLKOUT_DIVIDE_MAX)) {
+			dev_err(dev, "invalid output %d divide\n", i);
+			goto clk_node_err;
+		}
+
+		/* only first output has fractional divider */
+		if (i == 0)
+			of_property_read_u32(output_dn, "divide-fraction",
+					     &output[i].clkout_frac);
+		if ((output[i].clkout_frac >= MMCM_CLKOUT_FRAC_STEPS) ||
+		    (output[i].clkout_frac &&
+		     (output[i].clkout_divide < MMCM_CLKOUT_DIVIDE_F_MIN))) {
+			dev_err(dev, "invalid output %d divide fraction\n", i);
+			goto clk_node_err;
+		}
+
+		err = of_property_read_u32(output_dn, "duty",
+					   &output[i].clkout_duty);
+		if (err) {
+			dev_err(dev, "failed get output %d duty\n", i);
+			goto clk_node_err;
+		}
+		if ((output[i].clkout_duty < MMCM_CLKOUT_DUTY_MIN) ||
+		    (output[i].clkout_duty > MMCM_CLKOUT_DUTY_MAX)) {
+			dev_err(dev, "invalid output %d duty\n", i);
+			goto clk_node_err;
+		}
+
+		err = of_property_read_u32(output_dn, "phase",
+					   &output[i].clkout_phase);
+		if (err) {
+			dev_err(dev, "failed get output %d phase\n", i);
+			goto clk_node_err;
+		}
+		if (((int)output[i].clkout_phase < MMCM_CLKOUT_PHASE_MIN)
+			||
+		    (output[i].clkout_phase > MMCM_CLKOUT_PHASE_MAX)) {
+			dev_err(dev, "invalid output %d phase\n", i);
+			goto clk_node_err;
+		}
+
+clk_node_err:
+		of_node_put(output_dn);
+	}
+
+	if (i != outputs)
+		return -EINVAL;
+
+	if (!data->precise) {
+		dev_err(dev, "invalid precise-output\n");
+		return -EINVAL;
+	}
+
+	/* outputs without requested frequency keep DT divider */
+	for (i = 0; i < outputs; i++)
+		if (output[i].clkout_freq == 0)
+			output[i].clkout_freq = logiclk_calc_freq(&output[i]);
+
+	return 0;
+}
+
+/**
+ * logiclk_get_candidates - get best configurations for output frequency
+ * @clk: logiCLK output clock
+ * @rate: Requested output frequency
+ * @cand: Array of @num candidates
+ * @num: Maximum number of candidates
+ *
+ * Candidates are sorted by frequency error of requested output. Each one
+ * gives frequencies of all outputs, VCO frequency and whether full MMCM
+ * relock is needed. With pinned VCO only current configuration is given.
+ * Configuration is not changed.
+ *
+ * Returns number of candidates, or negative error code.
+ */
+int logiclk_get_candidates(struct clk *clk, unsigned long rate,
+			   struct logiclk_candidate *cand, unsigned int num)
+{
+	struct clk_hw *hw = __clk_get_hw(clk);
+	struct logiclk_output *output = NULL;
+	struct logiclk_data *data;
+	int i, ret = -EINVAL;
+
+	if (!hw || !cand || !num)
+		return -EINVAL;
+
+	mutex_lock(&logiclk_list_lock);
+	list_for_each_entry(data, &logiclk_list, list) {
+		for (i = 0; i < data->outputs; i++)
+			if (&data->output[i].hw == hw)
+				output = &data->output[i];
+		if (output) {
+			mutex_lock(&data->cfg_lock);
+			ret = logiclk_solve_candidates(output, rate, cand,
+						       num);
+			mutex_unlock(&data->cfg_lock);
+			break;
+		}
+	}
+	mutex_unlock(&logiclk_list_lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(logiclk_get_candidates);
+
+#ifdef CONFIG_DEBUG_FS
+static int logiclk_candidates_show(struct seq_file *s, void *unused)
+{
+	struct logiclk_data *data = s->private;
+	struct logiclk_candidate *cand;
+	unsigned long rate;
+	u32 output, num;
+	int i, j, cnt;
+
+	mutex_lock(&data->cfg_lock);
+	output = data->dbg_output;
+	rate = data->dbg_rate;
+	num = data->dbg_num;
+	mutex_unlock(&data->cfg_lock);
+
+	if (!rate) {
+		seq_puts(s, "write \"<output> <frequency> [<number>]\"\n");
+		return 0;
+	}
+
+	cand = kcalloc(num, sizeof(*cand), GFP_KERNEL);
+	if (!cand)
+		return -ENOMEM;
+
+	mutex_lock(&data->cfg_lock);
+	cnt = logiclk_solve_candidates(&data->output[output], rate, cand,
+				       num);
+	mutex_unlock(&data->cfg_lock);
+	if (cnt < 0) {
+		kfree(cand);
+		return cnt;
+	}
+
+	seq_printf(s, "output %u frequency %lu Hz\n", output, rate);
+	for (i = 0; i < cnt; i++) {
+		seq_printf(s, "M %u D %u VCO %lu Hz error %llu Hz relock %d:",
+			   cand[i].clkfbout_mult, cand[i].divclk_divide,
+			   cand[i].vco_rate, cand[i].rate_err,
+			   cand[i].relock);
+		for (j = 0; j < data->outputs; j++)
+			seq_printf(s, " %lu", cand[i].rate[j]);
+		seq_puts(s, "\n");
+	}
+
+	kfree(cand);
+
+	return 0;
+}
+
+static int logiclk_candidates_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, logiclk_candidates_show, inode->i_private);
+}
+
+static ssize_t logiclk_candidates_write(struct file *file,
+					const char __user *ubuf,
+					size_t count, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+	struct logiclk_data *data = s->private;
+	u32 output, num = LOGICLK_CANDIDATES_DEFAULT;
+	unsigned long rate;
+	char buf[32];
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	if (sscanf(buf, "%u %lu %u", &output, &rate, &num) < 2)
+		return -EINVAL;
+	if ((output >= data->outputs) || !rate || !num ||
+	    (num > LOGICLK_CANDIDATES_MAX))
+		return -EINVAL;
+
+	mutex_lock(&data->cfg_lock);
+	data->dbg_output = output;
+	data->dbg_rate = rate;
+	data->dbg_num = num;
+	mutex_unlock(&data->cfg_lock);
+
+	return count;
+}
+
+static const struct file_operations logiclk_candidates_fops = {
+	.owner = THIS_MODULE,
+	.open = logiclk_candidates_open,
+	.read = seq_read,
+	.write = logiclk_candidates_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static void logiclk_debugfs_init(struct logiclk_data *data)
+{
+	struct device *dev = data->dev;
+
+	data->debugfs = debugfs_create_dir(dev_name(dev), NULL);
+	debugfs_create_file("candidates", S_IRUGO | S_IWUSR, data->debugfs,
+			    data, &logiclk_candidates_fops);
+	debugfs_create_u32("lock_time_us", S_IRUGO, data->debugfs,
+			   &data->lock_time);
+	debugfs_create_u32("commit_failed", S_IRUGO, data->debugfs,
+			   &data->commit_failed);
+}
+
+static void logiclk_debugfs_exit(struct logiclk_data *data)
+{
+	debugfs_remove_recursive(data->debugfs);
+}
+#else
+static inline void logiclk_debugfs_init(struct logiclk_data *data)
+{
+}
+
+static inline void logiclk_debugfs_exit(struct logiclk_data *data)
+{
+}
+#endif
+
+static ssize_t vco_pinned_show(struct device *dev,
+			       struct device_attribute *attr, char *buf)
+{
+	struct logiclk_data *data = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%d\n", data->vco_pinned);
+}
+
+static ssize_t vco_pinned_store(struct device *dev,
+				struct device_attribute *attr,
+				const char *buf, size_t count)
+{
+	struct logiclk_data *data = dev_get_drvdata(dev);
+	bool pinned;
+	int err;
+
+	err = kstrtobool(buf, &pinned);
+	if (err)
+		return err;
+
+	mutex_lock(&data->cfg_lock);
+	if (pinned && !logiclk_vco_valid(data, logiclk_calc_vco(data)))
+		err = -EINVAL;
+	else
+		data->vco_pinned = pinned;
+	mutex_unlock(&data->cfg_lock);
+
+	return err ? err : count;
+}
+static DEVICE_ATTR_RW(vco_pinned);
+
+static ssize_t lock_lost_show(struct device *dev,
+			      struct device_attribute *attr, char *buf)
+{
+	struct logiclk_data *data = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%u\n", data->lock_lost);
+}
+static DEVICE_ATTR_RO(lock_lost);
+
+/*
+ * Register VCO and output clocks with clock providers. Without device,
+ * clocks are registered by early init and are never unregistered.
+ */
+static int logiclk_register_clocks(struct logiclk_data *data,
+				   struct device_node *dn)
+{
+	struct device *dev = data->dev;
+	struct clk_init_data init;
+	struct clk_hw_onecell_data *onecell = NULL;
+	const char *vco_name, *parent_name;
+	char name[64];
+	int i, j, err;
+
+	/*
+	 * Parent node with #clock-cells is a single provider for all outputs,
+	 * otherwise every output node is a provider of its own.
+	 */
+	if (of_find_property(dn, "#clock-cells", NULL)) {
+		onecell = logiclk_alloc(data, sizeof(*onecell) +
+					(data->outputs *
+					sizeof(struct clk_hw *)));
+		if (!onecell)
+			return -ENOMEM;
+		onecell->num = data->outputs;
+		data->onecell = onecell;
+	}
+
+	/* VCO name is unique by node unit address */
+	if (dev)
+		vco_name = devm_kasprintf(dev, GFP_KERNEL, "%s_vco",
+					  kbasename(dn->full_name));
+	else
+		vco_name = kasprintf(GFP_KERNEL, "%s_vco",
+				     kbasename(dn->full_name));
+	if (!vco_name)
+		return -ENOMEM;
+
+	memset(&init, 0, sizeof(init));
+
+	init.name = vco_name;
+	init.ops = &logiclk_vco_ops;
+	if (data->clk_in) {
+		parent_name = __clk_get_name(data->clk_in);
+		init.parent_names = &parent_name;
+		init.num_parents = 1;
+	}
+	data->vco_hw.init = &init;
+
+	if (dev)
+		err = devm_clk_hw_register(dev, &data->vco_hw);
+	else
+		err = clk_hw_register(NULL, &data->vco_hw);
+	if (err) {
+		dev_err(dev, "failed vco clk register\n");
+		return err;
+	}
+
+	init.ops = &logiclk_clk_ops;
+	init.parent_names = &vco_name;
+	init.num_parents = 1;
+
+	for (i = 0; i < data->outputs; i++) {
+		/* default names are unique by node unit address, as VCO name */
+		if (of_property_read_string_index(dn, "clock-output-names", i,
+						  &init.name)) {
+			snprintf(name, sizeof(name), "%s_clkout%d",
+				 kbasename(dn->full_name), i);
+			init.name = name;
+		}
+
+		/* only precise output changes VCO frequency */
+		init.flags = data->output[i].precise ? CLK_SET_RATE_PARENT : 0;
+		data->output[i].hw.init = &init;
+
+		if (dev)
+			err = devm_clk_hw_register(dev, &data->output[i].hw);
+		else
+			err = clk_hw_register(NULL, &data->output[i].hw);
+		if (err) {
+			dev_err(dev, "failed clk register\n");
+			goto err_clk;
+		}
+
+		if (onecell)
+			onecell->hws[i] = &data->output[i].hw;
+	}
+
+	if (onecell) {
+		if (dev)
+			err = devm_of_clk_add_hw_provider(dev,
+							  of_clk_hw_onecell_get,
+							  onecell);
+		else
+			err = of_clk_add_hw_provider(dn, of_clk_hw_onecell_get,
+						     onecell);
+		if (err) {
+			dev_err(dev, "failed clk add provider\n");
+			goto err_clk;
+		}
+		return 0;
+	}
+
+	for (j = 0; j < data->outputs; j++) {
+		err = of_clk_add_hw_provider(data->output[j].dn,
+					     of_clk_hw_simple_get,
+					     &data->output[j].hw);
+		if (err) {
+			dev_err(dev, "failed clk add provider\n");
+			for (--j; j >= 0; j--)
+				of_clk_del_provider(data->output[j].dn);
+			goto err_clk;
 		}
 	}
 
-	return logiclk_hw_config(output, LOGICLK_CONFIG_SW);
+	return 0;
+
+err_clk:
+	if (!dev) {
+		for (--i; i >= 0; i--)
+			clk_hw_unregister(&data->output[i].hw);
+		clk_hw_unregister(&data->vco_hw);
+		kfree(vco_name);
+	}
+
+	return err;
 }
 
-static const struct clk_ops logiclk_clk_ops = {
-	.recalc_rate = logiclk_recalc_rate,
-	.round_rate = logiclk_round_rate,
-	.set_rate = logiclk_set_rate,
-};
+static void logiclk_del_providers(struct logiclk_data *data)
+{
+	int i;
 
-static int logiclk_get_of_config(struct device_node *dn,
-				 struct logiclk_data *data, bool *set_freq)
+	if (data->onecell)
+		return;
+
+	for (i = (data->outputs - 1); i >= 0; i--)
+		of_clk_del_provider(data->output[i].dn);
+}
+
+/* Driver data shared by early init, probe and KUnit tests */
+static void logiclk_data_init(struct logiclk_data *data,
+			      const struct logiclk_family *family)
 {
-	struct device *dev = &data->pdev->dev;
-	struct device_node *output_dn = NULL;
-	struct logiclk_input *input = &data->input;
-	struct logiclk_output *output = data->output;
-	struct device_node *precise_dn;
-	int i, err, outputs;
+	data->family = family;
+	data->limits = family->limits;
+
+	INIT_WORK(&data->config_work, logiclk_config_work);
+	init_completion(&data->configured);
+	INIT_DELAYED_WORK(&data->lock_monitor, logiclk_lock_poll);
+	mutex_init(&data->cfg_lock);
+	mutex_init(&data->hw_lock);
+	data->man_regs = data->regs[0];
+	data->hw_regs = data->regs[1];
+	init_completion(&data->locked);
+}
 
-	outputs = of_get_child_count(dn);
-	if (outputs != LOGICLK_OUTPUTS) {
-		dev_err(dev, "invalid outputs number\n");
-		return -EINVAL;
+/* Runtime control: input clock, input clock notifier and interfaces */
+static int logiclk_attach(struct logiclk_data *data)
+{
+	struct device *dev = data->dev;
+	int err;
+
+	/* optional MMCM power-down, used while no output is prepared */
+	data->pwrdn = devm_reset_control_get_optional_exclusive(dev, NULL);
+	if (IS_ERR(data->pwrdn)) {
+		dev_err(dev, "failed get power-down control\n");
+		return PTR_ERR(data->pwrdn);
 	}
 
-	err = of_property_read_u32(dn, "input-frequency", &input->clk_freq);
-	if (err) {
-		dev_err(dev, "failed get input-frequency\n");
-		return err;
-	}
-	if ((input->clk_freq < MMCM_INPUT_FREQ_MIN) ||
-	    (input->clk_freq > MMCM_INPUT_FREQ_MAX)) {
-		dev_err(dev, "invalid input frequency\n");
-		return -EINVAL;
+	if (data->clk_in) {
+		err = clk_prepare_enable(data->clk_in);
+		if (err) {
+			dev_err(dev, "failed enable input clock\n");
+			return err;
+		}
+
+		data->input_nb.notifier_call = logiclk_input_notifier_cb;
+		err = clk_notifier_register(data->clk_in, &data->input_nb);
+		if (err) {
+			dev_err(dev, "failed register input clock notifier\n");
+			goto err_input;
+		}
 	}
 
-	err = of_property_read_u32(dn, "input-divide", &input->divclk_divide);
+	err = device_create_file(dev, &dev_attr_vco_pinned);
 	if (err) {
-		dev_err(dev, "failed get input-divide\n");
-		return err;
-	}
-	if ((input->divclk_divide < MMCM_DIVCLK_DIVIDE_MIN) ||
-	    (input->divclk_divide > MMCM_DIVCLK_DIVIDE_MAX)) {
-		dev_err(dev, "invalid input divide\n");
-		return -EINVAL;
+		dev_err(dev, "failed create vco_pinned attribute\n");
+		goto err_notifier;
 	}
 
-	err = of_property_read_u32(dn, "input-multiply", &input->clkfbout_mult);
+	err = device_create_file(dev, &dev_attr_lock_lost);
 	if (err) {
-		dev_err(dev, "failed get input-multiply\n");
-		return err;
-	}
-	if ((input->clkfbout_mult < MMCM_FBOUT_MULTIPLY_MIN) ||
-	    (input->clkfbout_mult > MMCM_FBOUT_MULTIPLY_MAX)) {
-		dev_err(dev, "invalid input multiply\n");
-		return -EINVAL;
+		dev_err(dev, "failed create lock_lost attribute\n");
+		goto err_pinned;
 	}
 
-	err = of_property_read_u32(dn, "input-phase", &input->clkfbout_phase);
-	if (err) {
-		dev_err(dev, "failed get input-phase\n");
-		return err;
+	/* lock status interrupt is optional, lock is polled without it */
+	data->irq = of_irq_get(data->dn, 0);
+	if (data->irq == -EPROBE_DEFER) {
+		err = -EPROBE_DEFER;
+		goto err_lost;
 	}
-	if (((s32)input->clkfbout_phase < MMCM_FBOUT_PHASE_MIN) ||
-	    (input->clkfbout_phase > MMCM_FBOUT_PHASE_MAX)) {
-		dev_err(dev, "invalid input phase\n");
-		return -EINVAL;
+	if (data->irq > 0) {
+		err = request_threaded_irq(data->irq, NULL, logiclk_lock_irq,
+					   IRQF_ONESHOT, dev_name(dev), data);
+		if (err) {
+			dev_err(dev, "failed request irq\n");
+			goto err_lost;
+		}
+		data->monitored = true;
+	} else {
+		data->irq = 0;
+		logiclk_lock_monitor_start(data);
 	}
 
-	if (of_property_read_bool(dn, "bandwidth-high"))
-		input->bw_high = true;
+	logiclk_debugfs_init(data);
 
-	precise_dn = of_parse_phandle(dn, "precise-output", 0);
-	if (!precise_dn) {
-		dev_err(dev, "failed get precise-output\n");
-		return -EINVAL;
+	pm_runtime_set_active(dev);
+	if (data->prepared)
+		pm_runtime_get_noresume(dev);
+	pm_runtime_enable(dev);
+
+	return 0;
+
+err_lost:
+	device_remove_file(dev, &dev_attr_lock_lost);
+err_pinned:
+	device_remove_file(dev, &dev_attr_vco_pinned);
+err_notifier:
+	if (data->clk_in)
+		clk_notifier_unregister(data->clk_in, &data->input_nb);
+err_input:
+	if (data->clk_in)
+		clk_disable_unprepare(data->clk_in);
+
+	return err;
+}
+
+static void logiclk_detach(struct logiclk_data *data)
+{
+	pm_runtime_disable(data->dev);
+	if (data->prepared)
+		pm_runtime_put_noidle(data->dev);
+
+	/* clocks of early registered device stay running after detach */
+	if (data->powered_down) {
+		mutex_lock(&data->hw_lock);
+		logiclk_power_up(data);
+		mutex_unlock(&data->hw_lock);
 	}
 
-	for (i = 0; i < outputs; i++) {
-		output_dn = of_get_next_child(dn, output_dn);
-		if (!output_dn)
-			break;
+	flush_work(&data->config_work);
 
-		output[i].dn = output_dn;
-		output[i].data = data;
-		output[i].id = i;
+	logiclk_debugfs_exit(data);
 
-		if (output_dn == precise_dn)
-			output[i].precise = true;
+	data->monitored = false;
+	if (data->irq)
+		free_irq(data->irq, data);
+	else
+		cancel_delayed_work_sync(&data->lock_monitor);
 
-		of_property_read_u32(output_dn, "frequency",
-				     &output[i].clkout_freq);
-		if ((output[i].clkout_freq != 0) &&
-		    ((output[i].clkout_freq < MMCM_OUTPUT_FREQ_MIN) ||
-		    (output[i].clkout_freq > MMCM_OUTPUT_FREQ_MAX))) {
-			dev_warn(dev, "unsupported output frequency\n");
-			output[i].clkout_freq = 0;
-		}
-		if (output[i].clkout_freq != 0)
-			*set_freq = true;
+	device_remove_file(data->dev, &dev_attr_lock_lost);
+	device_remove_file(data->dev, &dev_attr_vco_pinned);
 
-		err = of_property_read_u32(output_dn, "divide",
-					   &output[i].clkout_divide);
-		if (err) {
-			dev_err(dev, "failed get output %d divide\n", i);
-			goto clk_node_err;
-		}
-		if ((output[i].clkout_divide < MMCM_CLKOUT_DIVIDE_MIN) ||
-		    (output[i].clkout_divide > MMCM_CLKOUT_DIVIDE_MAX)) {
-			dev_err(dev, "invalid output %d divide\n", i);
-			goto clk_node_err;
-		}
+	if (data->clk_in) {
+		clk_notifier_unregister(data->clk_in, &data->input_nb);
+		clk_disable_unprepare(data->clk_in);
+	}
+}
 
-		err = of_property_read_u32(output_dn, "duty",
-					   &output[i].clkout_duty);
-		if (err) {
-			dev_err(dev, "failed get output %d duty\n", i);
-			goto clk_node_err;
-		}
-		if ((output[i].clkout_duty < MMCM_CLKOUT_DUTY_MIN) ||
-		    (output[i].clkout_duty > MMCM_CLKOUT_DUTY_MAX)) {
-			dev_err(dev, "invalid output %d duty\n", i);
-			goto clk_node_err;
-		}
+static struct logiclk_data *logiclk_find_early(struct device_node *dn)
+{
+	struct logiclk_data *data, *found = NULL;
 
-		err = of_property_read_u32(output_dn, "phase",
-					   &output[i].clkout_phase);
-		if (err) {
-			dev_err(dev, "failed get output %d phase\n", i);
-			goto clk_node_err;
-		}
-		if (((int)output[i].clkout_phase < MMCM_CLKOUT_PHASE_MIN)
-			||
-		    (output[i].clkout_phase > MMCM_CLKOUT_PHASE_MAX)) {
-			dev_err(dev, "invalid output %d phase\n", i);
-			goto clk_node_err;
+	mutex_lock(&logiclk_list_lock);
+	list_for_each_entry(data, &logiclk_list, list) {
+		if (data->early && (data->dn == dn)) {
+			found = data;
+			break;
 		}
+	}
+	mutex_unlock(&logiclk_list_lock);
 
-clk_node_err:
-		of_node_put(output_dn);
+	return found;
+}
+
+/*
+ * Frequency requested in DT is set through CCF, so consumers get rate change
+ * notifications. Outputs set by consumers keep their rates.
+ */
+static void logiclk_set_of_freq(struct logiclk_output *output)
+{
+	const struct logiclk_limits *limits = &output->data->limits;
+	u32 freq;
+
+	if (output->rate_set ||
+	    of_property_read_u32(output->dn, "frequency", &freq) || !freq)
+		return;
+
+	if ((freq < limits->output_freq_min) ||
+	    (freq > limits->output_freq_max)) {
+		dev_warn(output->data->dev,
+			 "unsupported output %d frequency\n", output->id);
+		return;
 	}
 
-	if (i != LOGICLK_OUTPUTS)
-		return -EINVAL;
+	if (clk_set_rate(output->hw.clk, freq))
+		dev_warn(output->data->dev,
+			 "failed set output %d frequency\n", output->id);
+}
+
+/*
+ * Early registered clocks give hw configuration frequencies. Frequencies
+ * requested in DT are set before register map is attached, so they are only
+ * staged, as rate changes made before attach are. Device takes over runtime
+ * control, and configuration work commits staged registers with single
+ * relock.
+ */
+static int logiclk_probe_early(struct platform_device *pdev,
+			       struct logiclk_data *data)
+{
+	struct device *dev = &pdev->dev;
+	struct regmap *regmap;
+	int i, err;
+
+	regmap = devm_regmap_init_mmio(dev, data->base, &logiclk_regmap_config);
+	if (IS_ERR(regmap)) {
+		dev_err(dev, "failed init register map\n");
+		return PTR_ERR(regmap);
+	}
+
+	data->dev = dev;
+	dev_set_drvdata(dev, data);
+
+	/* precise output first, other outputs take dividers from its VCO */
+	logiclk_set_of_freq(data->precise);
+	for (i = 0; i < data->outputs; i++)
+		if (&data->output[i] != data->precise)
+			logiclk_set_of_freq(&data->output[i]);
+
+	mutex_lock(&data->hw_lock);
+	data->regmap = regmap;
+	mutex_unlock(&data->hw_lock);
+
+	err = logiclk_attach(data);
+	if (err) {
+		mutex_lock(&data->hw_lock);
+		data->regmap = NULL;
+		mutex_unlock(&data->hw_lock);
+		data->dev = NULL;
+		return err;
+	}
+
+	/*
+	 * Deferred configuration waits for first prepare, unless outputs were
+	 * already prepared before attach.
+	 */
+	mutex_lock(&data->cfg_lock);
+	if (data->hw_regs_num) {
+		reinit_completion(&data->configured);
+		if (!data->deferred || data->prepared)
+			schedule_work(&data->config_work);
+	}
+	mutex_unlock(&data->cfg_lock);
 
 	return 0;
 }
@@ -886,16 +3366,16 @@ static int logiclk_probe(struct platform_device *pdev)
 {
 	struct device *dev = &pdev->dev;
 	struct device_node *dn = pdev->dev.of_node;
-	struct clk_init_data init;
-	struct clk *clk;
 	struct logiclk_data *data;
 	struct resource *res;
 	void __iomem *base;
-	int i, err;
-	int prec_id = 0;
-	char name[10];
+	int err;
 	bool set_freq = false;
 
+	data = logiclk_find_early(dn);
+	if (data)
+		return logiclk_probe_early(pdev, data);
+
 	res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
 	base = devm_ioremap_resource(dev, res);
 	if (IS_ERR(base))
@@ -907,84 +3387,254 @@ static int logiclk_probe(struct platform_device *pdev)
 		return -ENOMEM;
 	}
 	data->base = base;
-	data->pdev = pdev;
+	data->dev = dev;
+	data->dn = dn;
+	logiclk_data_init(data, of_device_get_match_data(dev));
+
+	data->regmap = devm_regmap_init_mmio(dev, base, &logiclk_regmap_config);
+	if (IS_ERR(data->regmap)) {
+		dev_err(dev, "failed init register map\n");
+		return PTR_ERR(data->regmap);
+	}
 
 	dev_set_drvdata(dev, data);
 
+	/* optional input clock replaces input-frequency */
+	data->clk_in = devm_clk_get(dev, NULL);
+	if (IS_ERR(data->clk_in)) {
+		if (PTR_ERR(data->clk_in) == -EPROBE_DEFER)
+			return -EPROBE_DEFER;
+		data->clk_in = NULL;
+	}
+
 	err = logiclk_get_of_config(dn, data, &set_freq);
 	if (err)
 		return err;
 
-	memset(&init, 0, sizeof(init));
-
-	init.name = name;
-	init.ops = &logiclk_clk_ops;
-	init.flags = CLK_IS_ROOT;
-
-	for (i = 0; i < LOGICLK_OUTPUTS; i++) {
-		sprintf(name, "clkout_%d", i);
-
-		data->output[i].hw.init = &init;
+	logiclk_state_save_of(data);
 
-		clk = devm_clk_register(dev, &data->output[i].hw);
-		if (IS_ERR(clk)) {
-			dev_err(dev, "failed clk register\n");
-			err = PTR_ERR(clk);
-			goto err_clk;
-		}
-		err = of_clk_add_provider(data->output[i].dn,
-					  of_clk_src_simple_get, clk);
-		if (err) {
-			dev_err(dev, "failed clk add provider\n");
-			goto err_clk;
+	/*
+	 * Configuration is solved before registration so CCF caches configured
+	 * rates, hw is programmed by configuration work.
+	 */
+	if (set_freq) {
+		if (logiclk_calc_params(data->precise)) {
+			dev_err(dev, "failed parameters calculation\n");
+			return -EINVAL;
 		}
-
-		if (data->output[i].precise)
-			prec_id = i;
+	} else {
+		logiclk_calc_outputs(data);
 	}
 
 	dev_info(dev, "precise output frequency %u Hz\n",
-		 logiclk_calc_freq(&data->output[prec_id]));
+		 logiclk_calc_freq(data->precise));
 
-	if (set_freq) {
-		if (logiclk_calc_params(&data->output[prec_id])) {
-			dev_err(dev, "failed parameters calculation\n");
-			goto err_clk;
-		}
-		logiclk_hw_config(&data->output[prec_id], LOGICLK_CONFIG_SW);
+	err = logiclk_register_clocks(data, dn);
+	if (err)
+		return err;
+
+	err = logiclk_attach(data);
+	if (err) {
+		logiclk_del_providers(data);
+		return err;
 	}
 
-	return 0;
+	mutex_lock(&logiclk_list_lock);
+	list_add_tail(&data->list, &logiclk_list);
+	mutex_unlock(&logiclk_list_lock);
 
-err_clk:
-	for (--i; i >= 0; i--)
-		of_clk_del_provider(data->output[i].dn);
+	if (!set_freq)
+		complete_all(&data->configured);
+	else if (!data->deferred)
+		schedule_work(&data->config_work);
 
-	return err;
+	return 0;
 }
 
 static int logiclk_remove(struct platform_device *pdev)
 {
 	struct device *dev = &pdev->dev;
 	struct logiclk_data *data = dev_get_drvdata(dev);
-	int i;
 
-	for (i = (LOGICLK_OUTPUTS - 1); i >= 0; i--)
-		of_clk_del_provider(data->output[i].dn);
+	logiclk_detach(data);
+
+	/* early registered clocks stay, without runtime control */
+	if (data->early) {
+		mutex_lock(&data->hw_lock);
+		data->regmap = NULL;
+		mutex_unlock(&data->hw_lock);
+		data->dev = NULL;
+		return 0;
+	}
+
+	mutex_lock(&logiclk_list_lock);
+	list_del(&data->list);
+	mutex_unlock(&logiclk_list_lock);
+
+	logiclk_del_providers(data);
+
+	return 0;
+}
+
+/*
+ * Committed registers are cached on every commit, so resume programs them
+ * again with single relock and no solver run. PL may come back from system
+ * sleep with bitstream defaults, or unconfigured.
+ */
+static int __maybe_unused logiclk_suspend(struct device *dev)
+{
+	struct logiclk_data *data = dev_get_drvdata(dev);
+
+	flush_work(&data->config_work);
+
+	if (!pm_runtime_status_suspended(dev))
+		logiclk_lock_monitor_stop(data);
+
+	return 0;
+}
+
+static int __maybe_unused logiclk_resume(struct device *dev)
+{
+	struct logiclk_data *data = dev_get_drvdata(dev);
+	int ret = 0;
+
+	/* monitor runs first, so lock interrupt signals replay lock */
+	mutex_lock(&data->hw_lock);
+	if (!pm_runtime_status_suspended(dev))
+		logiclk_lock_monitor_start(data);
+
+	/* powered down MMCM is programmed on runtime resume */
+	if (completion_done(&data->configured) && !data->powered_down)
+		ret = logiclk_hw_replay(data);
+	mutex_unlock(&data->hw_lock);
+
+	return ret;
+}
+
+static int __maybe_unused logiclk_runtime_suspend(struct device *dev)
+{
+	struct logiclk_data *data = dev_get_drvdata(dev);
+
+	logiclk_lock_monitor_stop(data);
+
+	if (data->pwrdn)
+		logiclk_power_down(data);
 
 	return 0;
 }
 
+static int __maybe_unused logiclk_runtime_resume(struct device *dev)
+{
+	struct logiclk_data *data = dev_get_drvdata(dev);
+	int ret = 0;
+
+	mutex_lock(&data->hw_lock);
+	logiclk_lock_monitor_start(data);
+
+	if (data->powered_down)
+		ret = logiclk_power_up(data);
+	else if (completion_done(&data->configured) &&
+		 !logiclk_hw_locked(data))
+		ret = logiclk_hw_replay(data);
+	mutex_unlock(&data->hw_lock);
+
+	return ret;
+}
+
+static const struct dev_pm_ops logiclk_pm_ops = {
+	SET_SYSTEM_SLEEP_PM_OPS(logiclk_suspend, logiclk_resume)
+	SET_RUNTIME_PM_OPS(logiclk_runtime_suspend, logiclk_runtime_resume,
+			   NULL)
+};
+
 static const struct of_device_id logiclk_of_match[] = {
-	{ .compatible = "xylon,logiclk-1.02.b" },
+	{
+		.compatible = "xylon,logiclk-1.02.b",
+		.data = &logiclk_family_7series,
+	},
+	{
+		.compatible = "xylon,logiclk-1.02.b-ultrascale",
+		.data = &logiclk_family_ultrascale,
+	},
 	{ },
 };
 MODULE_DEVICE_TABLE(of, logiclk_of_match);
 
+/*
+ * Early init registers clocks before platform devices are populated, so
+ * consumers do not defer probe. Hw is not touched, and clocks give hw
+ * configuration frequencies from DT until platform driver takes over.
+ * Register map reads hw defaults, so it is created by platform driver.
+ */
+static void __init logiclk_of_init(struct device_node *dn)
+{
+	const struct of_device_id *match = of_match_node(logiclk_of_match, dn);
+	struct logiclk_data *data;
+	bool set_freq = false;
+	int i;
+
+	data = kzalloc(sizeof(*data), GFP_KERNEL);
+	if (!data)
+		return;
+
+	data->dn = dn;
+	data->early = true;
+	logiclk_data_init(data, match->data);
+	complete_all(&data->configured);
+
+	/* input clock not registered yet is left to platform driver */
+	data->clk_in = of_clk_get(dn, 0);
+	if (IS_ERR(data->clk_in)) {
+		if (of_find_property(dn, "clocks", NULL))
+			goto err_free;
+		data->clk_in = NULL;
+	}
+
+	data->base = of_iomap(dn, 0);
+	if (!data->base) {
+		pr_err("%s: failed map registers\n", dn->full_name);
+		goto err_clk;
+	}
+
+	if (logiclk_get_of_config(dn, data, &set_freq))
+		goto err_unmap;
+
+	for (i = 0; i < data->outputs; i++)
+		data->output[i].clkout_freq =
+			logiclk_calc_freq(&data->output[i]);
+	logiclk_calc_outputs(data);
+	logiclk_state_save_of(data);
+
+	if (logiclk_register_clocks(data, dn))
+		goto err_unmap;
+
+	mutex_lock(&logiclk_list_lock);
+	list_add_tail(&data->list, &logiclk_list);
+	mutex_unlock(&logiclk_list_lock);
+
+	return;
+
+err_unmap:
+	iounmap(data->base);
+err_clk:
+	if (data->clk_in)
+		clk_put(data->clk_in);
+err_free:
+	kfree(data->onecell);
+	kfree(data->solver_table);
+	kfree(data->output);
+	kfree(data);
+}
+CLK_OF_DECLARE_DRIVER(logiclk, "xylon,logiclk-1.02.b", logiclk_of_init);
+CLK_OF_DECLARE_DRIVER(logiclk_ultrascale, "xylon,logiclk-1.02.b-ultrascale",
+		      logiclk_of_init);
+
 static struct platform_driver logiclk_driver = {
 	.driver = {
 		.name = "logiclk",
 		.of_match_table = logiclk_of_match,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
+		.pm = &logiclk_pm_ops,
 	},
 	.probe = logiclk_probe,
 	.remove = logiclk_remove,
@@ -994,3 +3644,7 @@ module_platform_driver(logiclk_driver);
 MODULE_DESCRIPTION("logiCLK clock generator driver");
 MODULE_LICENSE("GPL");
 MODULE_VERSION("1.0");
+
+#ifdef CONFIG_COMMON_CLK_LOGICLK_KUNIT_TEST
+#include "clk-logiclk_test.c"
+#endif
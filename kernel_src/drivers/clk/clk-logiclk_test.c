@@ -0,0 +1,985 @@
+/*
+ * KUnit tests for Xylon logiCLK IP Core Programmable Clock Generator
+ *
+ * Copyright (C) 2014 Xylon d.o.o.
+ * Author: Davor Joja <davor.joja@logicbricks.com>
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Included at the end of clk-logiclk.c, so static driver functions are
+ * tested directly. Registers are simulated in a logic_iomem region, lock
+ * drops on configuration command and comes back after a few lock status
+ * reads, unless the test makes it fail. Probe test applies DT overlay with
+ * logiCLK node placed in the same region.
+ */
+
+#include <kunit/of.h>
+#include <kunit/platform_device.h>
+#include <kunit/test.h>
+#include <linux/logic_iomem.h>
+#include <linux/of_platform.h>
+
+/* Simulated region, must match reg property of clk-logiclk_test.dtso */
+#define LOGICLK_TEST_BASE		0x7c000000
+#define LOGICLK_TEST_SIZE		0x1000
+
+#define LOGICLK_TEST_INPUT_FREQ		100000000
+#define LOGICLK_TEST_INPUT_MULT		10
+#define LOGICLK_TEST_INPUT_DIV		1
+#define LOGICLK_TEST_OUTPUTS		3
+#define LOGICLK_TEST_LOCK_READS		3
+#define LOGICLK_TEST_HW_REGS		(LOGICLK_PLL_MAN_REG_OFF + \
+					 LOGICLK_MANUAL_REGS)
+
+/*
+ * Maximum number of configurations evaluated by pruned, table and
+ * incremental solvers for test input frequencies. Exceeding it means
+ * the search lost its VCO range pruning.
+ */
+#define LOGICLK_TEST_ITERATIONS_MAX	512U
+
+static const u32 logiclk_test_inputs[] = {
+	10000000, 24000000, 27000000, 33333333,
+	74250000, 100000000, 148500000, 200000000,
+};
+
+static const u32 logiclk_test_rates[] = {
+	4690000, 25175000, 27000000, 33333333, 74250000, 108000000,
+	148500000, 297000000, 400000000, 533333333, 800000000,
+};
+
+static const u32 logiclk_test_divide[LOGICLK_TEST_OUTPUTS] = { 10, 20, 40 };
+
+/* Output frequencies of the overlay, given with input multiply 6 */
+static const u32 logiclk_test_dt_rates[LOGICLK_TEST_OUTPUTS] = {
+	100000000, 50000000, 25000000
+};
+
+/**
+ * struct logiclk_test_hw:
+ * @regs:		Simulated registers
+ * @configs:		Number of configuration commands
+ * @unlock_reads:	Lock status reads left until relock
+ * @locked:		MMCM lock status
+ * @failing:		Current configuration never locks
+ * @lock_fail:		Number of next configurations never locking
+ * @ignore_config:	Number of next configuration commands ignored
+ */
+struct logiclk_test_hw {
+	u32 regs[LOGICLK_TEST_HW_REGS];
+	u32 configs;
+	u32 unlock_reads;
+	bool locked;
+	bool failing;
+	u32 lock_fail;
+	u32 ignore_config;
+};
+
+/**
+ * struct logiclk_test:
+ * @data:		Driver data as set by probe
+ * @output:		Output clocks
+ * @hw:			Simulated hw
+ */
+struct logiclk_test {
+	struct logiclk_data data;
+	struct logiclk_output output[LOGICLK_TEST_OUTPUTS];
+	struct logiclk_test_hw hw;
+};
+
+/* Simulated hw given to next mapping of the region */
+static struct logiclk_test_hw *logiclk_test_mapped;
+
+static unsigned long logiclk_test_iomem_read(void *priv, unsigned int offset,
+					     int size)
+{
+	struct logiclk_test_hw *hw = priv;
+
+	if (offset >= sizeof(hw->regs))
+		return 0;
+
+	if (offset != (LOGICLK_PLL_REG_OFF * LOGICLK_REG_STRIDE))
+		return hw->regs[offset / LOGICLK_REG_STRIDE];
+
+	if (!hw->locked && hw->unlock_reads) {
+		if (!--hw->unlock_reads && !hw->failing)
+			hw->locked = true;
+		return 0;
+	}
+
+	return hw->locked ? LOGICLK_PLL_LOCK : 0;
+}
+
+static void logiclk_test_iomem_write(void *priv, unsigned int offset,
+				     int size, unsigned long val)
+{
+	struct logiclk_test_hw *hw = priv;
+
+	if (offset >= sizeof(hw->regs))
+		return;
+
+	hw->regs[offset / LOGICLK_REG_STRIDE] = val;
+
+	if ((offset != (LOGICLK_PLL_REG_OFF * LOGICLK_REG_STRIDE)) ||
+	    !(val & LOGICLK_PLL_CONFIG))
+		return;
+
+	hw->configs++;
+	if (hw->ignore_config) {
+		hw->ignore_config--;
+		return;
+	}
+
+	hw->locked = false;
+	hw->unlock_reads = LOGICLK_TEST_LOCK_READS;
+	hw->failing = (hw->lock_fail != 0);
+	if (hw->lock_fail)
+		hw->lock_fail--;
+}
+
+static const struct logic_iomem_ops logiclk_test_iomem_ops = {
+	.read = logiclk_test_iomem_read,
+	.write = logiclk_test_iomem_write,
+};
+
+static long logiclk_test_iomem_map(unsigned long offset, size_t size,
+				   const struct logic_iomem_ops **ops,
+				   void **priv)
+{
+	if (!logiclk_test_mapped)
+		return -ENODEV;
+
+	*ops = &logiclk_test_iomem_ops;
+	*priv = logiclk_test_mapped;
+
+	return offset;
+}
+
+static const struct logic_iomem_region_ops logiclk_test_region_ops = {
+	.map = logiclk_test_iomem_map,
+};
+
+static struct resource logiclk_test_res = {
+	.name = "logiclk-kunit",
+	.start = LOGICLK_TEST_BASE,
+	.end = LOGICLK_TEST_BASE + LOGICLK_TEST_SIZE - 1,
+	.flags = IORESOURCE_MEM,
+};
+
+static int logiclk_test_suite_init(struct kunit_suite *suite)
+{
+	/* region can not be removed, it stays for suite runs to come */
+	if (logiclk_test_res.parent)
+		return 0;
+
+	return logic_iomem_add_region(&logiclk_test_res,
+				      &logiclk_test_region_ops);
+}
+
+static int logiclk_test_init(struct kunit *test)
+{
+	struct platform_device *pdev;
+	struct logiclk_data *data;
+	struct logiclk_test *t;
+	int i;
+
+	t = kunit_kzalloc(test, sizeof(*t), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, t);
+	data = &t->data;
+
+	pdev = kunit_platform_device_alloc(test, "logiclk-kunit",
+					   PLATFORM_DEVID_AUTO);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, pdev);
+	KUNIT_ASSERT_EQ(test, kunit_platform_device_add(test, pdev), 0);
+	data->dev = &pdev->dev;
+
+	t->hw.locked = true;
+	logiclk_test_mapped = &t->hw;
+	data->base = ioremap(LOGICLK_TEST_BASE, LOGICLK_TEST_SIZE);
+	logiclk_test_mapped = NULL;
+	KUNIT_ASSERT_NOT_NULL(test, data->base);
+	data->regmap = regmap_init_mmio(NULL, data->base,
+					&logiclk_regmap_config);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, data->regmap);
+	test->priv = t;
+
+	logiclk_data_init(data, &logiclk_family_7series);
+	data->input.clk_freq = LOGICLK_TEST_INPUT_FREQ;
+	data->input.clkfbout_mult = LOGICLK_TEST_INPUT_MULT;
+	data->input.divclk_divide = LOGICLK_TEST_INPUT_DIV;
+	data->solver = logiclk_get_solver(LOGICLK_SOLVER_DEFAULT);
+
+	data->output = t->output;
+	data->outputs = LOGICLK_TEST_OUTPUTS;
+	data->precise = &t->output[0];
+	for (i = 0; i < LOGICLK_TEST_OUTPUTS; i++) {
+		t->output[i].data = data;
+		t->output[i].id = i;
+		t->output[i].clkout_divide = logiclk_test_divide[i];
+		t->output[i].clkout_duty = 50000;
+		t->output[i].clkout_freq = logiclk_calc_freq(&t->output[i]);
+	}
+	t->output[0].precise = true;
+	complete_all(&data->configured);
+	logiclk_man_reg_params_unused(data);
+
+	/* initial configuration, as programmed by probe */
+	logiclk_calc_outputs(data);
+	logiclk_state_save(data);
+	KUNIT_ASSERT_EQ(test, logiclk_hw_commit(data), 0);
+	t->hw.configs = 0;
+
+	return 0;
+}
+
+static void logiclk_test_exit(struct kunit *test)
+{
+	struct logiclk_test *t = test->priv;
+
+	regmap_exit(t->data.regmap);
+	iounmap(t->data.base);
+}
+
+static u64 logiclk_test_vco(struct logiclk_data *data)
+{
+	return div_u64((u64)data->input.clk_freq * data->input.clkfbout_mult,
+		       data->input.divclk_divide);
+}
+
+/* Output frequency closest to rate with integer output divider */
+static u64 logiclk_test_closest(u64 freq_vco, u64 rate)
+{
+	u64 freq, freq_err, best = 0, best_err = (u64)-1;
+	u32 divide;
+
+	for (divide = MMCM_CLKOUT_DIVIDE_MIN; divide <= MMCM_CLKOUT_DIVIDE_MAX;
+	     divide++) {
+		freq = div_u64(freq_vco, divide);
+		freq_err = (freq > rate) ? (freq - rate) : (rate - freq);
+		if (freq_err < best_err) {
+			best = freq;
+			best_err = freq_err;
+		}
+	}
+
+	return best;
+}
+
+/* Lowest output frequency error over VCO frequencies within limits */
+static u64 logiclk_test_best_err(struct logiclk_data *data, u64 clk_freq,
+				 u64 rate)
+{
+	const struct logiclk_limits *limits = &data->limits;
+	u64 freq, freq_vco, best_err = (u64)-1;
+	u32 m, d;
+
+	for (d = limits->divclk_divide_min; d <= limits->divclk_divide_max; d++)
+		for (m = limits->fbout_multiply_min;
+		     m <= limits->fbout_multiply_max; m++) {
+			freq_vco = div_u64(clk_freq * m, d);
+			if ((freq_vco < limits->vco_freq_min) ||
+			    (freq_vco > limits->vco_freq_max))
+				continue;
+
+			freq = logiclk_test_closest(freq_vco, rate);
+			freq = (freq > rate) ? (freq - rate) : (rate - freq);
+			if (freq < best_err)
+				best_err = freq;
+		}
+
+	return best_err;
+}
+
+/* Registers committed by driver are the ones programmed to hw */
+static void logiclk_test_expect_hw(struct kunit *test,
+				   struct logiclk_test_hw *hw,
+				   struct logiclk_data *data)
+{
+	int i;
+
+	for (i = 0; i < LOGICLK_MANUAL_REGS; i++)
+		KUNIT_EXPECT_EQ(test, hw->regs[LOGICLK_PLL_MAN_REG_OFF + i],
+				data->hw_regs[i]);
+}
+
+/*
+ * Fill solver table with every input multiplier and divider pair giving VCO
+ * within limits. Returns number of pairs.
+ */
+static u32 logiclk_test_pairs(struct logiclk_data *data)
+{
+	const struct logiclk_limits *limits = &data->limits;
+	u32 m, d, pairs = 0;
+	u64 freq_vco;
+
+	for (d = limits->divclk_divide_min; d <= limits->divclk_divide_max; d++)
+		for (m = limits->fbout_multiply_min;
+		     m <= limits->fbout_multiply_max; m++) {
+			freq_vco = div_u64((u64)data->input.clk_freq * m, d);
+			if ((freq_vco >= limits->vco_freq_min) &&
+			    (freq_vco <= limits->vco_freq_max)) {
+				data->solver_table[pairs * 2] = m;
+				data->solver_table[(pairs * 2) + 1] = d;
+				pairs++;
+			}
+		}
+
+	data->solver_table_len = pairs;
+
+	return pairs;
+}
+
+static void logiclk_test_solvers(struct kunit *test)
+{
+	struct logiclk_test *t = test->priv;
+	struct logiclk_data *data = &t->data;
+	struct logiclk_solution ref, sol;
+	u32 pairs, max_iterations;
+	int i, j, k;
+
+	data->solver_table = kunit_kcalloc(test,
+					   data->limits.divclk_divide_max *
+					   data->limits.fbout_multiply_max * 2,
+					   sizeof(u32), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, data->solver_table);
+
+	max_iterations = (data->limits.divclk_divide_max -
+			  data->limits.divclk_divide_min + 1) *
+			 (data->limits.fbout_multiply_max -
+			  data->limits.fbout_multiply_min + 1) *
+			 MMCM_CLKOUT_DIVIDE_MAX;
+
+	for (i = 0; i < ARRAY_SIZE(logiclk_test_inputs); i++) {
+		data->input.clk_freq = logiclk_test_inputs[i];
+		pairs = logiclk_test_pairs(data);
+		KUNIT_ASSERT_GT(test, pairs, 0U);
+
+		for (j = 0; j < ARRAY_SIZE(logiclk_test_rates); j++) {
+			logiclk_solution_init(&ref, 0);
+			ref.frac = false;
+			logiclk_solve_exhaustive(data, logiclk_test_rates[j],
+						 &ref);
+			KUNIT_EXPECT_LE(test, ref.iterations, max_iterations);
+			KUNIT_EXPECT_EQ_MSG(test, ref.freq_err,
+					    logiclk_test_best_err(data,
+						logiclk_test_inputs[i],
+						logiclk_test_rates[j]),
+					    "input %u Hz, output %u Hz",
+					    logiclk_test_inputs[i],
+					    logiclk_test_rates[j]);
+
+			for (k = 0; k < ARRAY_SIZE(logiclk_solvers); k++) {
+				if (logiclk_solvers[k].solve ==
+				    logiclk_solve_exhaustive)
+					continue;
+
+				logiclk_solution_init(&sol, 0);
+				sol.frac = false;
+				logiclk_solvers[k].solve(data,
+							 logiclk_test_rates[j],
+							 &sol);
+
+				KUNIT_EXPECT_EQ_MSG(test, sol.freq_err,
+						    ref.freq_err,
+						    "%s solver, input %u Hz, output %u Hz",
+						    logiclk_solvers[k].name,
+						    logiclk_test_inputs[i],
+						    logiclk_test_rates[j]);
+				KUNIT_EXPECT_FALSE(test, sol.exhausted);
+				KUNIT_EXPECT_LE(test, sol.iterations, pairs);
+				KUNIT_EXPECT_LE(test, sol.iterations,
+						LOGICLK_TEST_ITERATIONS_MAX);
+
+				/*
+				 * Only table solver keeps exhaustive search
+				 * order, others search outwards from current
+				 * VCO.
+				 */
+				if (logiclk_solvers[k].solve !=
+				    logiclk_solve_table)
+					continue;
+
+				KUNIT_EXPECT_EQ(test, sol.clkfbout_mult,
+						ref.clkfbout_mult);
+				KUNIT_EXPECT_EQ(test, sol.divclk_divide,
+						ref.divclk_divide);
+			}
+		}
+	}
+}
+
+static void logiclk_test_solver_budget(struct kunit *test)
+{
+	struct logiclk_test *t = test->priv;
+	struct logiclk_data *data = &t->data;
+	struct logiclk_solution full, sol;
+	u32 budget = 16;
+
+	logiclk_solution_init(&full, 0);
+	full.frac = false;
+	logiclk_solve_pruned(data, 148500000, &full);
+	KUNIT_EXPECT_FALSE(test, full.exhausted);
+	KUNIT_ASSERT_GT(test, full.iterations, budget);
+
+	logiclk_solution_init(&sol, budget);
+	sol.frac = false;
+	logiclk_solve_pruned(data, 148500000, &sol);
+	KUNIT_EXPECT_TRUE(test, sol.exhausted);
+	KUNIT_EXPECT_EQ(test, sol.iterations, budget);
+	KUNIT_EXPECT_NE(test, sol.clkfbout_mult, 0U);
+	KUNIT_EXPECT_GE(test, sol.freq_err, full.freq_err);
+
+	logiclk_solution_init(&sol, budget);
+	sol.frac = false;
+	logiclk_solve_exhaustive(data, 148500000, &sol);
+	KUNIT_EXPECT_TRUE(test, sol.exhausted);
+	KUNIT_EXPECT_EQ(test, sol.iterations, budget);
+
+	/* 1200 MHz VCO gives divider 8, first multiplier is 148.5 * 8 / 100 */
+	data->input.clkfbout_mult = 12;
+	logiclk_solution_init(&sol, 1);
+	sol.frac = false;
+	logiclk_solve_pruned(data, 148500000, &sol);
+	KUNIT_EXPECT_EQ(test, sol.clkfbout_mult, 12U);
+	KUNIT_EXPECT_EQ(test, sol.divclk_divide, 1U);
+}
+
+/* Lowest output frequency error of VCO over all output dividers */
+static u64 logiclk_test_vco_err_ref(u64 freq_vco, u64 freq_out, bool frac)
+{
+	u64 freq, freq_err, best = (u64)-1;
+	u32 divide;
+
+	for (divide = MMCM_CLKOUT_DIVIDE_MIN * MMCM_CLKOUT_FRAC_STEPS;
+	     divide <= MMCM_CLKOUT_DIVIDE_MAX * MMCM_CLKOUT_FRAC_STEPS;
+	     divide++) {
+		if ((divide % MMCM_CLKOUT_FRAC_STEPS) &&
+		    (!frac ||
+		     (divide <= MMCM_CLKOUT_DIVIDE_F_MIN *
+				MMCM_CLKOUT_FRAC_STEPS)))
+			continue;
+
+		freq = div_u64(freq_vco * MMCM_CLKOUT_FRAC_STEPS, divide);
+		freq_err = (freq > freq_out) ? (freq - freq_out) :
+					       (freq_out - freq);
+		if (freq_err < best)
+			best = freq_err;
+	}
+
+	return best;
+}
+
+static void logiclk_test_vco_err_check(struct kunit *test, u64 freq_vco,
+				       u64 freq_out, bool frac)
+{
+	u32 divide, divide_frac;
+	u64 freq_err, freq;
+
+	freq_err = logiclk_pll_vco_err(freq_vco, freq_out, frac, &divide,
+				       &divide_frac);
+	KUNIT_EXPECT_EQ_MSG(test, freq_err,
+			    logiclk_test_vco_err_ref(freq_vco, freq_out, frac),
+			    "VCO %llu Hz, output %llu Hz, frac %d",
+			    freq_vco, freq_out, frac);
+
+	/* returned divider gives returned error */
+	freq = div_u64(freq_vco * MMCM_CLKOUT_FRAC_STEPS,
+		       (divide * MMCM_CLKOUT_FRAC_STEPS) + divide_frac);
+	KUNIT_EXPECT_EQ(test, freq_err, (u64)abs((s64)(freq - freq_out)));
+
+	if (!frac)
+		KUNIT_EXPECT_EQ(test, divide_frac, 0U);
+	else if (divide_frac)
+		KUNIT_EXPECT_GE(test, divide, (u32)MMCM_CLKOUT_DIVIDE_F_MIN);
+}
+
+static void logiclk_test_vco_err(struct kunit *test)
+{
+	struct logiclk_test *t = test->priv;
+	const struct logiclk_limits *limits = &t->data.limits;
+	u64 freq_vco;
+	int i;
+
+	for (freq_vco = limits->vco_freq_min; freq_vco <= limits->vco_freq_max;
+	     freq_vco += 12345679) {
+		for (i = 0; i < ARRAY_SIZE(logiclk_test_rates); i++) {
+			logiclk_test_vco_err_check(test, freq_vco,
+						   logiclk_test_rates[i],
+						   false);
+			logiclk_test_vco_err_check(test, freq_vco,
+						   logiclk_test_rates[i],
+						   true);
+		}
+	}
+}
+
+static void logiclk_test_frac_count(struct kunit *test)
+{
+	static const struct {
+		u32 divide;
+		u32 frac;
+		u32 lt;
+		u32 ht;
+		u32 wf_rise;
+		u32 wf_fall;
+		u32 pm_fall;
+	} cases[] = {
+		{ 2, 1, 0, 0, 1, 1, 0 },
+		{ 5, 1, 1, 2, 0, 1, 4 },
+		{ 10, 4, 4, 4, 1, 1, 2 },
+		{ 127, 7, 63, 63, 0, 0, 7 },
+	};
+	u64 count;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(cases); i++) {
+		count = logiclk_pll_frac_count(cases[i].divide, cases[i].frac,
+					       0);
+
+		KUNIT_EXPECT_EQ(test, (u32)(count & 0x3F), cases[i].lt);
+		KUNIT_EXPECT_EQ(test, (u32)((count >> 6) & 0x3F), cases[i].ht);
+		KUNIT_EXPECT_EQ(test, (u32)((count >> 26) & 0x1),
+				cases[i].wf_rise);
+		KUNIT_EXPECT_EQ(test, (u32)((count >> 27) & 0x1), 1U);
+		KUNIT_EXPECT_EQ(test, (u32)((count >> 28) & 0x7),
+				cases[i].frac);
+		KUNIT_EXPECT_EQ(test, (u32)((count >> 32) & 0x1),
+				cases[i].wf_fall);
+		KUNIT_EXPECT_EQ(test, (u32)((count >> 33) & 0x7),
+				cases[i].pm_fall);
+	}
+}
+
+static void logiclk_test_candidate_insert(struct kunit *test)
+{
+	static const struct logiclk_candidate insert[] = {
+		{ .vco_rate = 1000, .rate_err = 30, .relock = true },
+		{ .vco_rate = 900, .rate_err = 10, .relock = true },
+		{ .vco_rate = 800, .rate_err = 10, .relock = false },
+		{ .vco_rate = 700, .rate_err = 40, .relock = true },
+		{ .vco_rate = 900, .rate_err = 10, .relock = false },
+		{ .vco_rate = 800, .rate_err = 5, .relock = true },
+		{ .vco_rate = 600, .rate_err = 0, .relock = true },
+	};
+	static const unsigned int cnt_expected[] = { 1, 2, 3, 3, 3, 3, 3 };
+	static const unsigned long vco_expected[] = { 600, 800, 900 };
+	struct logiclk_candidate cand[3], new;
+	unsigned int cnt = 0;
+	int i;
+
+	memset(cand, 0, sizeof(cand));
+
+	for (i = 0; i < ARRAY_SIZE(insert); i++) {
+		new = insert[i];
+		cnt = logiclk_candidate_insert(cand, cnt, ARRAY_SIZE(cand),
+					       &new);
+		KUNIT_EXPECT_EQ(test, cnt, cnt_expected[i]);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(cand); i++)
+		KUNIT_EXPECT_EQ(test, cand[i].vco_rate, vco_expected[i]);
+	KUNIT_EXPECT_TRUE(test, cand[0].relock);
+	KUNIT_EXPECT_FALSE(test, cand[1].relock);
+	KUNIT_EXPECT_FALSE(test, cand[2].relock);
+}
+
+static void logiclk_test_candidates(struct kunit *test)
+{
+	struct logiclk_test *t = test->priv;
+	struct logiclk_data *data = &t->data;
+	struct logiclk_output *output = &data->output[0];
+	struct logiclk_input *input = &data->input;
+	struct logiclk_candidate cand[4];
+	int cnt, i;
+
+	KUNIT_EXPECT_EQ(test, logiclk_solve_candidates(output,
+				data->limits.output_freq_max + 1, cand,
+				ARRAY_SIZE(cand)),
+			-EINVAL);
+	KUNIT_EXPECT_EQ(test, logiclk_solve_candidates(output,
+				data->limits.output_freq_min - 1, cand,
+				ARRAY_SIZE(cand)),
+			-EINVAL);
+
+	cnt = logiclk_solve_candidates(output, 148500000, cand,
+				       ARRAY_SIZE(cand));
+	KUNIT_EXPECT_EQ(test, cnt, (int)ARRAY_SIZE(cand));
+	for (i = 1; i < cnt; i++)
+		KUNIT_EXPECT_GE(test, cand[i].rate_err, cand[i - 1].rate_err);
+
+	/* pinned VCO gives current configuration only */
+	data->vco_pinned = true;
+	cnt = logiclk_solve_candidates(output, 148500000, cand,
+				       ARRAY_SIZE(cand));
+	KUNIT_EXPECT_EQ(test, cnt, 1);
+	KUNIT_EXPECT_EQ(test, cand[0].clkfbout_mult, input->clkfbout_mult);
+	KUNIT_EXPECT_EQ(test, cand[0].divclk_divide, input->divclk_divide);
+	KUNIT_EXPECT_EQ(test, cand[0].vco_rate,
+			(unsigned long)logiclk_test_vco(data));
+	KUNIT_EXPECT_FALSE(test, cand[0].relock);
+}
+
+static void logiclk_test_set_rate(struct kunit *test)
+{
+	struct logiclk_test *t = test->priv;
+	struct logiclk_data *data = &t->data;
+	u64 freq_vco = logiclk_test_vco(data);
+	unsigned long parent = freq_vco;
+	u32 configs = 0;
+	long rate;
+	int i;
+
+	for (i = 0; i < LOGICLK_TEST_OUTPUTS; i++) {
+		struct clk_hw *hw = &data->output[i].hw;
+
+		/* outputs other than precise one keep VCO */
+		if (data->output[i].precise)
+			continue;
+
+		rate = logiclk_round_rate(hw, 40000000 + (i * 1000000),
+					  &parent);
+		KUNIT_EXPECT_EQ(test, (u64)rate,
+				logiclk_test_closest(freq_vco,
+						     40000000 + (i * 1000000)));
+
+		KUNIT_EXPECT_EQ(test, logiclk_set_rate(hw, rate, parent), 0);
+		KUNIT_EXPECT_EQ(test, logiclk_recalc_rate(hw, parent),
+				(unsigned long)rate);
+		KUNIT_EXPECT_EQ(test, t->hw.configs, ++configs);
+		KUNIT_EXPECT_EQ(test, logiclk_test_vco(data), freq_vco);
+		KUNIT_EXPECT_EQ(test, (u64)parent, freq_vco);
+		logiclk_test_expect_hw(test, &t->hw, data);
+	}
+}
+
+static void logiclk_test_set_rate_precise(struct kunit *test)
+{
+	struct logiclk_test *t = test->priv;
+	struct logiclk_data *data = &t->data;
+	struct clk_hw *hw = &data->precise->hw;
+	u32 freq[LOGICLK_TEST_OUTPUTS];
+	unsigned long parent = logiclk_test_vco(data);
+	u64 freq_vco;
+	long rate;
+	int i;
+
+	for (i = 0; i < LOGICLK_TEST_OUTPUTS; i++)
+		freq[i] = data->output[i].clkout_freq;
+
+	/* 125 MHz is exact from 1 GHz VCO, only output divider changes */
+	rate = logiclk_round_rate(hw, 125000000, &parent);
+	KUNIT_EXPECT_EQ(test, rate, 125000000L);
+	KUNIT_EXPECT_EQ(test, parent, (unsigned long)logiclk_test_vco(data));
+	KUNIT_EXPECT_EQ(test, data->pending.vco_freq, 0ULL);
+
+	/* 148.5 MHz misses 1 GHz VCO, new VCO is solved and kept pending */
+	rate = logiclk_round_rate(hw, 148500000, &parent);
+	KUNIT_ASSERT_GT(test, rate, 0L);
+	KUNIT_EXPECT_EQ(test, (u64)abs(rate - 148500000L),
+			logiclk_test_best_err(data, data->input.clk_freq,
+					      148500000));
+
+	freq_vco = parent;
+	KUNIT_EXPECT_NE(test, freq_vco, 1000000000ULL);
+	KUNIT_EXPECT_EQ(test, freq_vco, data->pending.vco_freq);
+	KUNIT_EXPECT_GE(test, freq_vco, data->limits.vco_freq_min);
+	KUNIT_EXPECT_LE(test, freq_vco, data->limits.vco_freq_max);
+	KUNIT_EXPECT_EQ(test, logiclk_test_vco(data), 1000000000ULL);
+
+	/* CCF sets VCO first, then precise output, with one relock */
+	KUNIT_EXPECT_EQ(test, logiclk_vco_set_rate(&data->vco_hw, parent,
+						   data->input.clk_freq), 0);
+	KUNIT_EXPECT_EQ(test, logiclk_test_vco(data), freq_vco);
+	KUNIT_EXPECT_EQ(test, logiclk_set_rate(hw, rate, parent), 0);
+	KUNIT_EXPECT_EQ(test, t->hw.configs, 1U);
+	KUNIT_EXPECT_EQ(test, logiclk_recalc_rate(hw, parent),
+			(unsigned long)rate);
+	KUNIT_EXPECT_EQ(test, data->pending.vco_freq, 0ULL);
+
+	/* other outputs are retuned to closest frequency from new VCO */
+	for (i = 1; i < LOGICLK_TEST_OUTPUTS; i++)
+		KUNIT_EXPECT_EQ(test,
+				(u64)logiclk_recalc_rate(&data->output[i].hw,
+							 parent),
+				logiclk_test_closest(freq_vco, freq[i]));
+
+	logiclk_test_expect_hw(test, &t->hw, data);
+}
+
+static void logiclk_test_lock_timeout(struct kunit *test)
+{
+	struct logiclk_test *t = test->priv;
+	struct logiclk_data *data = &t->data;
+	struct clk_hw *hw = &data->output[1].hw;
+	unsigned long parent = logiclk_test_vco(data);
+	u32 freq = t->output[1].clkout_freq;
+	u32 regs[LOGICLK_MANUAL_REGS];
+
+	memcpy(regs, &t->hw.regs[LOGICLK_PLL_MAN_REG_OFF], sizeof(regs));
+
+	/* configuration never locks, previous one is restored */
+	t->hw.lock_fail = 1;
+	KUNIT_EXPECT_EQ(test, logiclk_set_rate(hw, 40000000, parent),
+			-ETIMEDOUT);
+	KUNIT_EXPECT_EQ(test, t->hw.configs, 2U);
+	KUNIT_EXPECT_EQ(test, data->commit_failed, 1U);
+	KUNIT_EXPECT_EQ(test, t->output[1].clkout_freq, freq);
+	KUNIT_EXPECT_EQ(test, logiclk_recalc_rate(hw, parent),
+			(unsigned long)freq);
+	KUNIT_EXPECT_MEMEQ(test, &t->hw.regs[LOGICLK_PLL_MAN_REG_OFF], regs,
+			   sizeof(regs));
+	KUNIT_EXPECT_TRUE(test, t->hw.locked);
+
+	/* configuration command not taken */
+	t->hw.ignore_config = 1;
+	KUNIT_EXPECT_EQ(test, logiclk_set_rate(hw, 40000000, parent),
+			-ETIMEDOUT);
+	KUNIT_EXPECT_EQ(test, t->hw.configs, 4U);
+	KUNIT_EXPECT_EQ(test, data->commit_failed, 2U);
+	KUNIT_EXPECT_EQ(test, t->output[1].clkout_freq, freq);
+
+	/* next rate change locks */
+	KUNIT_EXPECT_EQ(test, logiclk_set_rate(hw, 40000000, parent), 0);
+	KUNIT_EXPECT_EQ(test, t->hw.configs, 5U);
+	KUNIT_EXPECT_EQ(test, logiclk_recalc_rate(hw, parent), 40000000UL);
+	logiclk_test_expect_hw(test, &t->hw, data);
+}
+
+static void logiclk_test_lock_timeout_hw_config(struct kunit *test)
+{
+	struct logiclk_test *t = test->priv;
+	struct logiclk_data *data = &t->data;
+	struct clk_hw *hw = &data->output[1].hw;
+	unsigned long parent = logiclk_test_vco(data);
+	u32 freq = t->output[1].clkout_freq;
+	u32 regs[LOGICLK_MANUAL_REGS];
+
+	/* hw configuration active, as before initial configuration */
+	memcpy(regs, data->hw_regs, sizeof(regs));
+	memset(data->hw_regs, 0, sizeof(data->regs[0]));
+	data->hw_regs_num = 0;
+
+	/* staged registers are encoded from restored parameters */
+	t->hw.lock_fail = 1;
+	KUNIT_EXPECT_EQ(test, logiclk_set_rate(hw, 40000000, parent),
+			-ETIMEDOUT);
+	KUNIT_EXPECT_EQ(test, data->hw_regs_num, 0);
+	KUNIT_EXPECT_EQ(test, t->output[1].clkout_freq, freq);
+	KUNIT_EXPECT_MEMEQ(test, data->man_regs, regs, sizeof(regs));
+	KUNIT_EXPECT_TRUE(test, t->hw.locked);
+
+	/* next rate change commits a complete image */
+	KUNIT_EXPECT_EQ(test, logiclk_set_rate(hw, 40000000, parent), 0);
+	KUNIT_EXPECT_EQ(test, data->hw_regs_num, LOGICLK_MANUAL_REGS);
+	KUNIT_EXPECT_EQ(test, logiclk_recalc_rate(hw, parent), 40000000UL);
+	logiclk_test_expect_hw(test, &t->hw, data);
+}
+
+static void logiclk_test_lock_restore(struct kunit *test)
+{
+	struct logiclk_test *t = test->priv;
+	struct logiclk_data *data = &t->data;
+
+	/* lock kept, nothing is programmed */
+	logiclk_lock_restore(data);
+	KUNIT_EXPECT_EQ(test, data->lock_lost, 0U);
+	KUNIT_EXPECT_EQ(test, t->hw.configs, 0U);
+
+	/* lock lost, committed registers are programmed again */
+	t->hw.locked = false;
+	memset(&t->hw.regs[LOGICLK_PLL_MAN_REG_OFF], 0,
+	       LOGICLK_MANUAL_REGS * sizeof(u32));
+	logiclk_lock_restore(data);
+	KUNIT_EXPECT_EQ(test, data->lock_lost, 1U);
+	KUNIT_EXPECT_EQ(test, t->hw.configs, 1U);
+	KUNIT_EXPECT_TRUE(test, t->hw.locked);
+	logiclk_test_expect_hw(test, &t->hw, data);
+}
+
+static void logiclk_test_prepare_deferred(struct kunit *test)
+{
+	struct logiclk_test *t = test->priv;
+	struct logiclk_data *data = &t->data;
+
+	data->deferred = true;
+	reinit_completion(&data->configured);
+
+	KUNIT_EXPECT_EQ(test, logiclk_prepare(&t->output[1].hw), 0);
+	KUNIT_EXPECT_TRUE(test, completion_done(&data->configured));
+	KUNIT_EXPECT_EQ(test, t->hw.configs, 1U);
+
+	/* later consumers do not commit again */
+	KUNIT_EXPECT_EQ(test, logiclk_prepare(&t->output[2].hw), 0);
+	KUNIT_EXPECT_EQ(test, t->hw.configs, 1U);
+	logiclk_test_expect_hw(test, &t->hw, data);
+}
+
+static void logiclk_test_prepare_config_err(struct kunit *test)
+{
+	struct logiclk_test *t = test->priv;
+	struct logiclk_data *data = &t->data;
+	struct clk_hw *hw = &data->output[1].hw;
+
+	data->deferred = true;
+	reinit_completion(&data->configured);
+
+	/* initial configuration never locks */
+	t->hw.lock_fail = 1;
+	KUNIT_EXPECT_EQ(test, logiclk_prepare(hw), -ETIMEDOUT);
+	KUNIT_EXPECT_EQ(test, data->config_err, -ETIMEDOUT);
+
+	/* outputs can be prepared once a rate change commits */
+	KUNIT_EXPECT_EQ(test, logiclk_set_rate(hw, 40000000,
+					       logiclk_test_vco(data)), 0);
+	KUNIT_EXPECT_EQ(test, data->config_err, 0);
+	KUNIT_EXPECT_EQ(test, logiclk_prepare(hw), 0);
+	logiclk_test_expect_hw(test, &t->hw, data);
+}
+
+static void logiclk_test_rollback(struct kunit *test)
+{
+	struct logiclk_test *t = test->priv;
+	struct logiclk_data *data = &t->data;
+	struct logiclk_output output[LOGICLK_TEST_OUTPUTS];
+	struct logiclk_input input = data->input;
+	u32 man_regs[LOGICLK_MANUAL_REGS];
+	unsigned long parent = logiclk_test_vco(data);
+	int i;
+
+	memcpy(output, data->output, sizeof(output));
+	memcpy(man_regs, data->man_regs, sizeof(man_regs));
+
+	/* rejected rates leave outputs, registers and VCO untouched */
+	for (i = 0; i < LOGICLK_TEST_OUTPUTS; i++) {
+		struct clk_hw *hw = &data->output[i].hw;
+
+		KUNIT_EXPECT_EQ(test, logiclk_round_rate(hw,
+					data->limits.output_freq_max + 1,
+					&parent),
+				(long)-EINVAL);
+		KUNIT_EXPECT_EQ(test, logiclk_round_rate(hw,
+					data->limits.output_freq_min - 1,
+					&parent),
+				(long)-EINVAL);
+	}
+	KUNIT_EXPECT_EQ(test, parent, (unsigned long)logiclk_test_vco(data));
+	KUNIT_EXPECT_EQ(test, data->pending.vco_freq, 0ULL);
+
+	/* pinned VCO rejects precise rates its dividers miss */
+	data->vco_pinned = true;
+	KUNIT_EXPECT_EQ(test, logiclk_round_rate(&data->precise->hw, 148500000,
+						 &parent),
+			(long)-EINVAL);
+	KUNIT_EXPECT_EQ(test, parent, (unsigned long)logiclk_test_vco(data));
+	KUNIT_EXPECT_EQ(test, logiclk_vco_set_rate(&data->vco_hw, parent / 2,
+						   data->input.clk_freq),
+			-EBUSY);
+
+	KUNIT_EXPECT_MEMEQ(test, data->output, output, sizeof(output));
+	KUNIT_EXPECT_MEMEQ(test, data->man_regs, man_regs, sizeof(man_regs));
+	KUNIT_EXPECT_MEMEQ(test, &data->input, &input, sizeof(input));
+	KUNIT_EXPECT_EQ(test, t->hw.configs, 0U);
+	logiclk_test_expect_hw(test, &t->hw, data);
+}
+
+static void logiclk_test_probe(struct kunit *test)
+{
+	struct of_phandle_args clkspec = { .args_count = 1 };
+	struct logiclk_test_hw *hw;
+	struct platform_device *pdev;
+	struct logiclk_data *data;
+	struct device_node *dn;
+	struct clk *clk;
+	char name[32];
+	int i;
+
+	hw = kunit_kzalloc(test, sizeof(*hw), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, hw);
+	hw->locked = true;
+
+	logiclk_test_mapped = hw;
+	KUNIT_ASSERT_EQ(test, of_overlay_apply_kunit(test, clk_logiclk_test),
+			0);
+	wait_for_device_probe();
+	logiclk_test_mapped = NULL;
+
+	dn = of_find_compatible_node(NULL, NULL, "xylon,logiclk-1.02.b");
+	KUNIT_ASSERT_NOT_NULL(test, dn);
+	of_node_put_kunit(test, dn);
+
+	pdev = of_find_device_by_node(dn);
+	KUNIT_ASSERT_NOT_NULL(test, pdev);
+	data = platform_get_drvdata(pdev);
+	put_device(&pdev->dev);
+	KUNIT_ASSERT_NOT_NULL(test, data);
+
+	/* outputs give DT frequencies, precise output one is programmed */
+	KUNIT_ASSERT_EQ(test, data->outputs, LOGICLK_TEST_OUTPUTS);
+	clkspec.np = dn;
+	for (i = 0; i < LOGICLK_TEST_OUTPUTS; i++) {
+		clkspec.args[0] = i;
+		clk = of_clk_get_from_provider(&clkspec);
+		KUNIT_EXPECT_NOT_ERR_OR_NULL(test, clk);
+		if (IS_ERR(clk))
+			continue;
+
+		snprintf(name, sizeof(name), "logiclk_test_out%d", i);
+		KUNIT_EXPECT_STREQ(test, __clk_get_name(clk), name);
+		KUNIT_EXPECT_EQ(test, clk_get_rate(clk),
+				(unsigned long)logiclk_test_dt_rates[i]);
+		KUNIT_EXPECT_EQ(test, data->output[i].clkout_freq,
+				logiclk_test_dt_rates[i]);
+		clk_put(clk);
+	}
+	clkspec.args[0] = LOGICLK_TEST_OUTPUTS;
+	KUNIT_EXPECT_TRUE(test, IS_ERR(of_clk_get_from_provider(&clkspec)));
+
+	/* VCO range narrowed by DT keeps solved VCO within it */
+	KUNIT_EXPECT_EQ(test, data->limits.vco_freq_max, 1200000000ULL);
+	KUNIT_EXPECT_TRUE(test, logiclk_vco_valid(data,
+						  logiclk_calc_vco(data)));
+
+	/* initial configuration is programmed by configuration work */
+	wait_for_completion(&data->configured);
+	KUNIT_EXPECT_EQ(test, data->config_err, 0);
+	KUNIT_EXPECT_EQ(test, hw->configs, 1U);
+	logiclk_test_expect_hw(test, hw, data);
+}
+
+static struct kunit_case logiclk_test_cases[] = {
+	KUNIT_CASE(logiclk_test_solvers),
+	KUNIT_CASE(logiclk_test_solver_budget),
+	KUNIT_CASE(logiclk_test_vco_err),
+	KUNIT_CASE(logiclk_test_frac_count),
+	KUNIT_CASE(logiclk_test_candidate_insert),
+	KUNIT_CASE(logiclk_test_candidates),
+	KUNIT_CASE(logiclk_test_set_rate),
+	KUNIT_CASE(logiclk_test_set_rate_precise),
+	KUNIT_CASE(logiclk_test_lock_timeout),
+	KUNIT_CASE(logiclk_test_lock_timeout_hw_config),
+	KUNIT_CASE(logiclk_test_lock_restore),
+	KUNIT_CASE(logiclk_test_prepare_deferred),
+	KUNIT_CASE(logiclk_test_prepare_config_err),
+	KUNIT_CASE(logiclk_test_rollback),
+	KUNIT_CASE(logiclk_test_probe),
+	{ }
+};
+
+static struct kunit_suite logiclk_test_suite = {
+	.name = "clk-logiclk",
+	.suite_init = logiclk_test_suite_init,
+	.init = logiclk_test_init,
+	.exit = logiclk_test_exit,
+	.test_cases = logiclk_test_cases,
+};
+
+kunit_test_suite(logiclk_test_suite);
@@ -0,0 +1,58 @@
+/*
+ * Xylon logiCLK IP Core Programmable Clock Generator consumer interface
+ *
+ * Copyright (C) 2014 Xylon d.o.o.
+ * Author: Davor Joja <davor.joja@logicbricks.com>
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __LINUX_CLK_LOGICLK_H
+#define __LINUX_CLK_LOGICLK_H
+
+#include <linux/errno.h>
+#include <linux/types.h>
+
+#define LOGICLK_OUTPUTS_MAX		6
+
+struct clk;
+
+/**
+ * struct logiclk_candidate:
+ * @clkfbout_mult:	Input clock multiplier
+ * @divclk_divide:	Input clock divider
+ * @vco_rate:		VCO frequency
+ * @rate:		Achieved frequencies of all outputs, in output order
+ * @rate_err:		Frequency error of requested output
+ * @relock:		Configuration changes input multiplier or divider and
+ *			needs full MMCM relock
+ */
+struct logiclk_candidate {
+	u32 clkfbout_mult;
+	u32 divclk_divide;
+	unsigned long vco_rate;
+	unsigned long rate[LOGICLK_OUTPUTS_MAX];
+	u64 rate_err;
+	bool relock;
+};
+
+#if IS_ENABLED(CONFIG_COMMON_CLK_LOGICLK)
+int logiclk_get_candidates(struct clk *clk, unsigned long rate,
+			   struct logiclk_candidate *cand, unsigned int num);
+#else
+static inline int logiclk_get_candidates(struct clk *clk, unsigned long rate,
+					 struct logiclk_candidate *cand,
+					 unsigned int num)
+{
+	return -ENOSYS;
+}
+#endif
+
+#endif /* __LINUX_CLK_LOGICLK_H */
@@ -0,0 +1,458 @@
+/*
+ * Host build shims for Xylon logiCLK driver solver verification
+ *
+ * Copyright (C) 2014 Xylon d.o.o.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Every <linux/...> header included by clk-logiclk.c resolves to this file,
+ * so the driver compiles unmodified on the host. Arithmetic helpers used by
+ * the solvers are implemented, everything else is only declared. Kernel
+ * interfaces are referenced by driver code the verifier never calls, which
+ * the compiler drops as unused, so they are never linked.
+ */
+
+#ifndef __LOGICLK_HOST_H
+#define __LOGICLK_HOST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+/* types */
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef unsigned long long u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef long long s64;
+typedef s64 ktime_t;
+typedef int irqreturn_t;
+typedef char *charp;
+
+#define __iomem
+#define __init
+#define __maybe_unused		__attribute__((unused))
+
+/* errors */
+#define EIO			5
+#define ENOMEM			12
+#define EBUSY			16
+#define EINVAL			22
+#define ETIMEDOUT		110
+#define EPROBE_DEFER		517
+
+#define IS_ERR(x)		((unsigned long)(x) > (unsigned long)-4096)
+#define PTR_ERR(x)		((long)(x))
+#define ERR_PTR(x)		((void *)(long)(x))
+
+/* config */
+#define __ARG_PLACEHOLDER_1	0,
+#define __take_second_arg(__ignored, val, ...) val
+#define __is_defined(x)		___is_defined(x)
+#define ___is_defined(val)	____is_defined(__ARG_PLACEHOLDER_##val)
+#define ____is_defined(arg)	__take_second_arg(arg 1, 0)
+#define IS_ENABLED(option)	__is_defined(option)
+
+/* arithmetic */
+#define BIT(n)			(1UL << (n))
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+#define container_of(ptr, type, member) \
+	((type *)((char *)(ptr) - offsetof(type, member)))
+
+#define min(a, b)		((a) < (b) ? (a) : (b))
+#define max(a, b)		((a) > (b) ? (a) : (b))
+#define min_t(t, a, b)		((t)(a) < (t)(b) ? (t)(a) : (t)(b))
+#define max_t(t, a, b)		((t)(a) > (t)(b) ? (t)(a) : (t)(b))
+#define clamp_t(t, v, lo, hi)	min_t(t, max_t(t, v, lo), hi)
+#define clamp(v, lo, hi)	min(max(v, lo), hi)
+#define swap(a, b) \
+	do { typeof(a) __tmp = (a); (a) = (b); (b) = __tmp; } while (0)
+#define roundup(x, y)		((((x) + (y) - 1) / (y)) * (y))
+#define rounddown(x, y)		((x) - ((x) % (y)))
+#undef abs
+#define abs(x)			((x) < 0 ? -(x) : (x))
+
+static inline u64 div_u64(u64 dividend, u32 divisor)
+{
+	return dividend / divisor;
+}
+
+static inline u64 div64_u64(u64 dividend, u64 divisor)
+{
+	return dividend / divisor;
+}
+
+/* module */
+struct module;
+#define THIS_MODULE		((struct module *)0)
+#define S_IRUGO			0444
+#define module_param(name, type, perm)
+#define module_param_named(name, value, type, perm)
+#define EXPORT_SYMBOL_GPL(sym)
+#define MODULE_PARM_DESC(name, desc)
+#define MODULE_DEVICE_TABLE(type, name)
+#define MODULE_DESCRIPTION(desc)
+#define MODULE_LICENSE(license)
+#define MODULE_VERSION(version)
+
+/* lists and locking */
+struct list_head {
+	struct list_head *next, *prev;
+};
+
+#define LIST_HEAD(name) \
+	struct list_head name = { &(name), &(name) }
+#define list_for_each_entry(pos, head, member)				\
+	for (pos = container_of((head)->next, typeof(*pos), member);	\
+	     &pos->member != (head);					\
+	     pos = container_of(pos->member.next, typeof(*pos), member))
+void list_add_tail(struct list_head *new, struct list_head *head);
+void list_del(struct list_head *entry);
+
+struct mutex {
+	int count;
+};
+
+#define DEFINE_MUTEX(name)	struct mutex name
+void mutex_init(struct mutex *lock);
+void mutex_lock(struct mutex *lock);
+int mutex_trylock(struct mutex *lock);
+void mutex_unlock(struct mutex *lock);
+
+/* completions and work */
+struct completion {
+	unsigned int done;
+};
+
+void init_completion(struct completion *x);
+void reinit_completion(struct completion *x);
+void complete(struct completion *x);
+void complete_all(struct completion *x);
+bool completion_done(struct completion *x);
+void wait_for_completion(struct completion *x);
+unsigned long wait_for_completion_timeout(struct completion *x,
+					  unsigned long timeout);
+
+struct work_struct {
+	void (*func)(struct work_struct *work);
+};
+
+struct delayed_work {
+	struct work_struct work;
+};
+
+#define INIT_WORK(w, f)		((w)->func = (f))
+#define INIT_DELAYED_WORK(w, f)	((w)->work.func = (f))
+#define to_delayed_work(w)	container_of(w, struct delayed_work, work)
+bool schedule_work(struct work_struct *work);
+bool schedule_delayed_work(struct delayed_work *dwork, unsigned long delay);
+bool cancel_delayed_work_sync(struct delayed_work *dwork);
+void flush_work(struct work_struct *work);
+
+/* time */
+ktime_t ktime_get(void);
+s64 ktime_to_ns(ktime_t kt);
+#define ktime_sub(a, b)		((a) - (b))
+s64 ktime_to_us(ktime_t kt);
+unsigned long msecs_to_jiffies(unsigned int m);
+unsigned long usecs_to_jiffies(unsigned int u);
+
+/* devices */
+struct device_node {
+	const char *name;
+	const char *full_name;
+};
+
+struct kobject {
+	int state;
+};
+
+struct device {
+	struct device_node *of_node;
+	struct kobject kobj;
+};
+
+struct resource {
+	u64 start;
+};
+
+struct platform_device {
+	const char *name;
+	struct device dev;
+};
+
+struct of_device_id {
+	char compatible[128];
+	const void *data;
+};
+
+struct dev_pm_ops {
+	int (*suspend)(struct device *dev);
+	int (*resume)(struct device *dev);
+};
+
+#define SET_SYSTEM_SLEEP_PM_OPS(suspend_fn, resume_fn)
+#define SET_RUNTIME_PM_OPS(suspend_fn, resume_fn, idle_fn)
+
+struct platform_driver {
+	int (*probe)(struct platform_device *pdev);
+	int (*remove)(struct platform_device *pdev);
+	struct {
+		const char *name;
+		const struct of_device_id *of_match_table;
+		const struct dev_pm_ops *pm;
+		int probe_type;
+	} driver;
+};
+
+#define PROBE_PREFER_ASYNCHRONOUS	1
+
+struct attribute {
+	const char *name;
+	unsigned short mode;
+};
+
+struct device_attribute {
+	struct attribute attr;
+	ssize_t (*show)(struct device *dev, struct device_attribute *attr,
+			char *buf);
+	ssize_t (*store)(struct device *dev, struct device_attribute *attr,
+			 const char *buf, size_t count);
+};
+
+#define DEVICE_ATTR_RW(name)	struct device_attribute dev_attr_##name
+#define DEVICE_ATTR_RO(name)	struct device_attribute dev_attr_##name
+int device_create_file(struct device *dev,
+		       const struct device_attribute *attr);
+void device_remove_file(struct device *dev,
+			const struct device_attribute *attr);
+void sysfs_notify(struct kobject *kobj, const char *dir, const char *attr);
+int kstrtobool(const char *s, bool *res);
+
+#define module_platform_driver(drv)
+
+#define dev_err(dev, fmt, ...)	fprintf(stderr, fmt, ##__VA_ARGS__)
+#define dev_warn(dev, fmt, ...)	fprintf(stderr, fmt, ##__VA_ARGS__)
+#define dev_info(dev, fmt, ...)	fprintf(stderr, fmt, ##__VA_ARGS__)
+const char *dev_name(const struct device *dev);
+#define pr_err(fmt, ...)	fprintf(stderr, fmt, ##__VA_ARGS__)
+#define dev_dbg(dev, fmt, ...)	\
+	do { if (0) fprintf(stderr, fmt, ##__VA_ARGS__); } while (0)
+void dev_set_drvdata(struct device *dev, void *data);
+void *dev_get_drvdata(const struct device *dev);
+struct resource *platform_get_resource(struct platform_device *pdev,
+				       unsigned int type, unsigned int num);
+void __iomem *devm_ioremap_resource(struct device *dev, struct resource *res);
+#define IORESOURCE_MEM		0x00000200
+const void *of_device_get_match_data(const struct device *dev);
+
+/* memory and register access */
+#define GFP_KERNEL		0
+void *devm_kzalloc(struct device *dev, size_t size, int flags);
+void *kzalloc(size_t size, int flags);
+void kfree(const void *p);
+char *kasprintf(int flags, const char *fmt, ...);
+const char *kbasename(const char *path);
+void *devm_kcalloc(struct device *dev, size_t n, size_t size, int flags);
+char *devm_kasprintf(struct device *dev, int flags, const char *fmt, ...);
+u32 clk_readl(void __iomem *reg);
+void clk_writel(u32 val, void __iomem *reg);
+#define readl_poll_timeout(addr, val, cond, sleep_us, timeout_us) \
+	({ (val) = clk_readl(addr); (cond) ? 0 : -ETIMEDOUT; })
+#define readl_poll_timeout_atomic(addr, val, cond, delay_us, timeout_us) \
+	readl_poll_timeout(addr, val, cond, delay_us, timeout_us)
+
+/* interrupts */
+#define IRQ_NONE		0
+#define IRQ_HANDLED		1
+#define IRQF_ONESHOT		0x00002000
+int request_threaded_irq(unsigned int irq,
+			 irqreturn_t (*handler)(int irq, void *dev_id),
+			 irqreturn_t (*thread_fn)(int irq, void *dev_id),
+			 unsigned long flags, const char *name, void *dev_id);
+void free_irq(unsigned int irq, void *dev_id);
+void enable_irq(unsigned int irq);
+void disable_irq(unsigned int irq);
+
+/* runtime PM and reset */
+struct reset_control;
+struct reset_control *devm_reset_control_get_optional_exclusive(
+	struct device *dev, const char *id);
+int reset_control_assert(struct reset_control *rstc);
+int reset_control_deassert(struct reset_control *rstc);
+void pm_runtime_enable(struct device *dev);
+void pm_runtime_disable(struct device *dev);
+int pm_runtime_set_active(struct device *dev);
+int pm_runtime_get_sync(struct device *dev);
+int pm_runtime_put(struct device *dev);
+void pm_runtime_put_noidle(struct device *dev);
+void pm_runtime_get_noresume(struct device *dev);
+bool pm_runtime_status_suspended(struct device *dev);
+
+/* device tree */
+void __iomem *of_iomap(struct device_node *np, int index);
+void iounmap(void __iomem *addr);
+const struct of_device_id *of_match_node(const struct of_device_id *matches,
+					 const struct device_node *node);
+int of_irq_get(struct device_node *dev, int index);
+int of_property_read_u32(const struct device_node *np, const char *name,
+			 u32 *value);
+int of_property_read_u32_array(const struct device_node *np,
+			       const char *name, u32 *values, size_t sz);
+int of_property_read_string(const struct device_node *np, const char *name,
+			    const char **value);
+int of_property_read_string_index(const struct device_node *np,
+				  const char *name, int index,
+				  const char **output);
+bool of_find_property(const struct device_node *np, const char *name,
+		      int *lenp);
+int of_property_count_u32_elems(const struct device_node *np,
+				const char *name);
+bool of_property_read_bool(const struct device_node *np, const char *name);
+int of_get_child_count(const struct device_node *np);
+struct device_node *of_parse_phandle(const struct device_node *np,
+				     const char *name, int index);
+struct device_node *of_get_next_child(const struct device_node *node,
+				      struct device_node *prev);
+void of_node_put(struct device_node *node);
+
+/* clocks */
+struct clk;
+struct clk_hw;
+
+struct clk_init_data {
+	const char *name;
+	const struct clk_ops *ops;
+	const char * const *parent_names;
+	u8 num_parents;
+	unsigned long flags;
+};
+
+struct clk_hw {
+	struct clk *clk;
+	const struct clk_init_data *init;
+};
+
+struct clk_ops {
+	int (*prepare)(struct clk_hw *hw);
+	void (*unprepare)(struct clk_hw *hw);
+	unsigned long (*recalc_rate)(struct clk_hw *hw,
+				     unsigned long parent_rate);
+	long (*round_rate)(struct clk_hw *hw, unsigned long rate,
+			   unsigned long *parent_rate);
+	int (*set_rate)(struct clk_hw *hw, unsigned long rate,
+			unsigned long parent_rate);
+};
+
+struct of_phandle_args {
+	struct device_node *np;
+	int args_count;
+	u32 args[16];
+};
+
+#define CLK_SET_RATE_PARENT	BIT(2)
+#define CLK_GET_RATE_NOCACHE	BIT(6)
+#define PRE_RATE_CHANGE		BIT(0)
+#define POST_RATE_CHANGE	BIT(1)
+#define NOTIFY_DONE		0
+#define NOTIFY_OK		1
+#define NOTIFY_BAD		0x8002
+#define CLK_OF_DECLARE_DRIVER(name, compat, fn)
+
+struct notifier_block {
+	int (*notifier_call)(struct notifier_block *nb, unsigned long action,
+			     void *data);
+};
+
+struct clk_notifier_data {
+	struct clk *clk;
+	unsigned long old_rate;
+	unsigned long new_rate;
+};
+
+struct clk_hw_onecell_data {
+	unsigned int num;
+	struct clk_hw *hws[];
+};
+
+struct clk *of_clk_get(struct device_node *np, int index);
+void clk_put(struct clk *clk);
+struct clk *devm_clk_get(struct device *dev, const char *id);
+struct clk_hw *__clk_get_hw(struct clk *clk);
+const char *__clk_get_name(const struct clk *clk);
+unsigned long clk_get_rate(struct clk *clk);
+int clk_set_rate(struct clk *clk, unsigned long rate);
+int clk_prepare_enable(struct clk *clk);
+void clk_disable_unprepare(struct clk *clk);
+int clk_notifier_register(struct clk *clk, struct notifier_block *nb);
+int clk_notifier_unregister(struct clk *clk, struct notifier_block *nb);
+int notifier_from_errno(int err);
+int clk_hw_register(struct device *dev, struct clk_hw *hw);
+void clk_hw_unregister(struct clk_hw *hw);
+int devm_clk_hw_register(struct device *dev, struct clk_hw *hw);
+struct clk_hw *of_clk_hw_simple_get(struct of_phandle_args *clkspec,
+				    void *data);
+struct clk_hw *of_clk_hw_onecell_get(struct of_phandle_args *clkspec,
+				     void *data);
+int of_clk_add_hw_provider(struct device_node *np,
+			   struct clk_hw *(*get)(struct of_phandle_args *spec,
+						 void *data),
+			   void *data);
+int devm_of_clk_add_hw_provider(struct device *dev,
+				struct clk_hw *(*get)(
+					struct of_phandle_args *spec,
+					void *data),
+				void *data);
+void of_clk_del_provider(struct device_node *np);
+
+/* register map */
+struct regmap;
+
+enum regcache_type {
+	REGCACHE_NONE,
+	REGCACHE_RBTREE,
+	REGCACHE_COMPRESSED,
+	REGCACHE_FLAT,
+};
+
+struct regmap_config {
+	int reg_bits;
+	int reg_stride;
+	int val_bits;
+	bool (*writeable_reg)(struct device *dev, unsigned int reg);
+	bool (*readable_reg)(struct device *dev, unsigned int reg);
+	bool (*volatile_reg)(struct device *dev, unsigned int reg);
+	unsigned int max_register;
+	enum regcache_type cache_type;
+	unsigned int num_reg_defaults_raw;
+};
+
+struct regmap *devm_regmap_init_mmio(struct device *dev, void __iomem *regs,
+				     const struct regmap_config *config);
+int regmap_read(struct regmap *map, unsigned int reg, unsigned int *val);
+int regmap_write(struct regmap *map, unsigned int reg, unsigned int val);
+int regmap_update_bits(struct regmap *map, unsigned int reg,
+		       unsigned int mask, unsigned int val);
+int regcache_sync(struct regmap *map);
+void regcache_cache_only(struct regmap *map, bool enable);
+void regcache_mark_dirty(struct regmap *map);
+#define regmap_read_poll_timeout(map, addr, val, cond, sleep_us, timeout_us) \
+	({ regmap_read(map, addr, &(val)); (cond) ? 0 : -ETIMEDOUT; })
+
+#endif /* __LOGICLK_HOST_H */
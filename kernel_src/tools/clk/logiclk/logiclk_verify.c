@@ -0,0 +1,539 @@
+/*
+ * Differential verifier for Xylon logiCLK driver solvers
+ *
+ * Copyright (C) 2014 Xylon d.o.o.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Driver is compiled unmodified into this program, so the solvers checked
+ * are exactly the ones running on the board. For every input frequency and
+ * every swept output frequency, an independent brute-force search over all
+ * input multipliers, input dividers and output dividers gives the reference
+ * error. The exhaustive driver solver must match it exactly, every other
+ * solver must not give larger error. Output divider error of every VCO
+ * frequency, logiclk_pll_vco_err(), is checked against the brute-force
+ * output divider loop on the way. With an iterations budget, searches
+ * stopped on budget report their gap to the reference error instead.
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "clk-logiclk.c"
+
+#define VERIFY_RATES_DEFAULT	20000
+#define VERIFY_CHUNK		64
+#define VERIFY_REPORT_MAX	20
+#define VERIFY_INPUTS_MAX	64
+
+static const u32 verify_inputs_default[] = {
+	10000000, 12288000, 24000000, 25000000, 27000000, 33333333,
+	50000000, 74250000, 100000000, 125000000, 148500000, 200000000,
+};
+
+/**
+ * struct verify_input:
+ * @data:		Driver data with input frequency, limits, current
+ *			input multiplier and divider and full solver table
+ * @rates:		Swept output frequencies
+ * @rates_num:		Number of swept output frequencies
+ */
+struct verify_input {
+	struct logiclk_data data;
+	u64 *rates;
+	unsigned int rates_num;
+};
+
+/**
+ * struct verify_stats:
+ * @cases:		Number of checked output frequencies per solver
+ * @worse:		Cases with larger error than reference
+ * @differ:		Cases with reference error but different input
+ *			multiplier or divider
+ * @spent:		Cases stopped on iterations budget
+ * @gap_max:		Maximum error above reference of budgeted cases, in
+ *			ppm of output frequency
+ * @iterations:		Sum of solver iterations
+ * @iterations_max:	Maximum solver iterations
+ */
+struct verify_stats {
+	u64 cases;
+	u64 worse;
+	u64 differ;
+	u64 spent;
+	u64 gap_max;
+	u64 iterations;
+	u32 iterations_max;
+};
+
+/**
+ * struct verify_result:
+ * @stats:		Solver statistics, indexed as driver solvers
+ * @vco_err:		logiclk_pll_vco_err() mismatches
+ * @reference:		Exhaustive solver mismatches with brute force
+ */
+struct verify_result {
+	struct verify_stats stats[ARRAY_SIZE(logiclk_solvers)];
+	u64 vco_err;
+	u64 reference;
+};
+
+static struct verify_input verify_input[VERIFY_INPUTS_MAX];
+static unsigned int verify_inputs;
+static u64 verify_cases;
+static u64 verify_next;
+static bool verify_frac;
+static u32 verify_budget;
+static bool verify_verbose;
+static unsigned int verify_reported;
+static struct verify_result verify_total;
+static pthread_mutex_t verify_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void verify_report(const char *fmt, ...)
+	__attribute__((format(printf, 1, 2)));
+
+static void verify_report(const char *fmt, ...)
+{
+	va_list args;
+
+	pthread_mutex_lock(&verify_lock);
+	if (verify_verbose || (verify_reported < VERIFY_REPORT_MAX)) {
+		va_start(args, fmt);
+		vprintf(fmt, args);
+		va_end(args);
+	}
+	verify_reported++;
+	pthread_mutex_unlock(&verify_lock);
+}
+
+/* Output dividers in 1/8 steps valid for integer or fractional search */
+static bool verify_divide_valid(u32 divide, bool frac)
+{
+	if (divide % MMCM_CLKOUT_FRAC_STEPS == 0)
+		return true;
+
+	return frac &&
+	       (divide > MMCM_CLKOUT_DIVIDE_F_MIN * MMCM_CLKOUT_FRAC_STEPS);
+}
+
+/*
+ * Brute-force search over every input multiplier, input divider and output
+ * divider, keeping the first configuration with the lowest error in the
+ * exhaustive solver order. Checks logiclk_pll_vco_err() for every VCO.
+ */
+static void verify_brute(struct logiclk_data *data, u64 freq_out, bool frac,
+			 struct logiclk_solution *sol,
+			 struct verify_result *res)
+{
+	const struct logiclk_limits *limits = &data->limits;
+	u64 clk_freq_input = data->input.clk_freq;
+	u64 freq_vco, freq_err, vco_err, err;
+	u32 m, d, divide, clkout_divide, clkout_frac;
+
+	logiclk_solution_init(sol, 0);
+
+	for (d = limits->divclk_divide_min; d <= limits->divclk_divide_max;
+	     d++) {
+		for (m = limits->fbout_multiply_min;
+		     m <= limits->fbout_multiply_max; m++) {
+			freq_vco = (clk_freq_input * m) / d;
+			if ((freq_vco < limits->vco_freq_min) ||
+			    (freq_vco > limits->vco_freq_max))
+				continue;
+
+			vco_err = (u64)-1;
+			for (divide = MMCM_CLKOUT_DIVIDE_MIN *
+				      MMCM_CLKOUT_FRAC_STEPS;
+			     divide <= MMCM_CLKOUT_DIVIDE_MAX *
+				       MMCM_CLKOUT_FRAC_STEPS;
+			     divide++) {
+				if (!verify_divide_valid(divide, frac))
+					continue;
+
+				freq_err = (freq_vco * MMCM_CLKOUT_FRAC_STEPS) /
+					   divide;
+				freq_err = (freq_err > freq_out) ?
+					   (freq_err - freq_out) :
+					   (freq_out - freq_err);
+				if (freq_err < vco_err)
+					vco_err = freq_err;
+			}
+
+			err = logiclk_pll_vco_err(freq_vco, freq_out, frac,
+						  &clkout_divide, &clkout_frac);
+			if (err != vco_err) {
+				res->vco_err++;
+				verify_report("vco_err: VCO %llu Hz, output %llu Hz%s: error %llu Hz, brute force %llu Hz\n",
+					      freq_vco, freq_out,
+					      frac ? " fractional" : "",
+					      err, vco_err);
+			}
+
+			logiclk_solution_update(sol, m, d, vco_err);
+		}
+	}
+}
+
+static void verify_case(struct verify_input *vin, u64 freq_out, bool frac,
+			struct verify_result *res)
+{
+	struct logiclk_data *data = &vin->data;
+	struct logiclk_solution ref, sol;
+	struct verify_stats *stats;
+	u64 gap;
+	int i;
+
+	verify_brute(data, freq_out, frac, &ref, res);
+
+	for (i = 0; i < ARRAY_SIZE(logiclk_solvers); i++) {
+		/* exhaustive solver covers integer output dividers only */
+		if (frac && (logiclk_solvers[i].solve ==
+			     logiclk_solve_exhaustive))
+			continue;
+
+		stats = &res->stats[i];
+
+		logiclk_solution_init(&sol, verify_budget);
+		sol.frac = frac;
+		logiclk_solvers[i].solve(data, freq_out, &sol);
+
+		stats->cases++;
+		stats->iterations += sol.iterations;
+		if (sol.iterations > stats->iterations_max)
+			stats->iterations_max = sol.iterations;
+
+		if (sol.exhausted && (sol.freq_err >= ref.freq_err)) {
+			stats->spent++;
+			/* no configuration found within budget */
+			if (!sol.clkfbout_mult)
+				continue;
+			gap = div64_u64((sol.freq_err - ref.freq_err) * 1000000,
+					freq_out);
+			if (gap > stats->gap_max)
+				stats->gap_max = gap;
+			continue;
+		}
+
+		if (sol.freq_err == ref.freq_err &&
+		    sol.clkfbout_mult == ref.clkfbout_mult &&
+		    sol.divclk_divide == ref.divclk_divide)
+			continue;
+
+		if (logiclk_solvers[i].solve == logiclk_solve_exhaustive) {
+			res->reference++;
+		} else if (sol.freq_err > ref.freq_err) {
+			stats->worse++;
+		} else if (sol.freq_err == ref.freq_err) {
+			stats->differ++;
+			if (!verify_verbose)
+				continue;
+		} else {
+			/* better than brute force means broken reference */
+			res->reference++;
+		}
+
+		verify_report("%s: input %u Hz, output %llu Hz%s: M %u D %u error %llu Hz, reference M %u D %u error %llu Hz\n",
+			      logiclk_solvers[i].name, data->input.clk_freq,
+			      freq_out, frac ? " fractional" : "",
+			      sol.clkfbout_mult, sol.divclk_divide,
+			      sol.freq_err, ref.clkfbout_mult,
+			      ref.divclk_divide, ref.freq_err);
+	}
+}
+
+static void verify_merge(struct verify_result *res)
+{
+	int i;
+
+	pthread_mutex_lock(&verify_lock);
+	for (i = 0; i < ARRAY_SIZE(logiclk_solvers); i++) {
+		verify_total.stats[i].cases += res->stats[i].cases;
+		verify_total.stats[i].worse += res->stats[i].worse;
+		verify_total.stats[i].differ += res->stats[i].differ;
+		verify_total.stats[i].spent += res->stats[i].spent;
+		if (res->stats[i].gap_max > verify_total.stats[i].gap_max)
+			verify_total.stats[i].gap_max = res->stats[i].gap_max;
+		verify_total.stats[i].iterations += res->stats[i].iterations;
+		if (res->stats[i].iterations_max >
+		    verify_total.stats[i].iterations_max)
+			verify_total.stats[i].iterations_max =
+				res->stats[i].iterations_max;
+	}
+	verify_total.vco_err += res->vco_err;
+	verify_total.reference += res->reference;
+	pthread_mutex_unlock(&verify_lock);
+}
+
+static void *verify_thread(void *arg)
+{
+	struct verify_result res;
+	struct verify_input *vin;
+	u64 first, c, idx;
+	unsigned int i;
+
+	memset(&res, 0, sizeof(res));
+
+	for (;;) {
+		first = __atomic_fetch_add(&verify_next, VERIFY_CHUNK,
+					   __ATOMIC_RELAXED);
+		if (first >= verify_cases)
+			break;
+
+		for (c = first; c < min(first + VERIFY_CHUNK, verify_cases);
+		     c++) {
+			idx = c;
+			for (i = 0; idx >= verify_input[i].rates_num; i++)
+				idx -= verify_input[i].rates_num;
+			vin = &verify_input[i];
+
+			verify_case(vin, vin->rates[idx], false, &res);
+			if (verify_frac)
+				verify_case(vin, vin->rates[idx], true, &res);
+		}
+	}
+
+	verify_merge(&res);
+
+	return NULL;
+}
+
+static int verify_cmp(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+	return (x > y) - (x < y);
+}
+
+/*
+ * Evenly spaced output frequencies over the output range, and optionally
+ * every output frequency achievable with an integer output divider.
+ */
+static int verify_input_init(struct verify_input *vin,
+			     const struct logiclk_family *family, u32 clk_freq,
+			     unsigned int rates_num, bool achievable)
+{
+	struct logiclk_data *data = &vin->data;
+	const struct logiclk_limits *limits = &family->limits;
+	u64 freq_vco, span;
+	u32 m, d, o;
+	unsigned int i, n = 0, max = rates_num;
+
+	data->family = family;
+	data->limits = family->limits;
+	data->input.clk_freq = clk_freq;
+
+	if (achievable)
+		max += (limits->divclk_divide_max *
+			limits->fbout_multiply_max * MMCM_CLKOUT_DIVIDE_MAX);
+
+	data->solver_table = calloc(limits->divclk_divide_max *
+				    limits->fbout_multiply_max * 2,
+				    sizeof(u32));
+	vin->rates = calloc(max, sizeof(u64));
+	if (!data->solver_table || !vin->rates)
+		return -ENOMEM;
+
+	/* table solver gets every input multiplier and divider pair */
+	for (d = limits->divclk_divide_min; d <= limits->divclk_divide_max;
+	     d++) {
+		for (m = limits->fbout_multiply_min;
+		     m <= limits->fbout_multiply_max; m++) {
+			freq_vco = ((u64)clk_freq * m) / d;
+			if ((freq_vco < limits->vco_freq_min) ||
+			    (freq_vco > limits->vco_freq_max))
+				continue;
+
+			data->solver_table[data->solver_table_len * 2] = m;
+			data->solver_table[(data->solver_table_len * 2) + 1] =
+				d;
+			data->solver_table_len++;
+
+			if (!achievable)
+				continue;
+
+			for (o = MMCM_CLKOUT_DIVIDE_MIN;
+			     o <= MMCM_CLKOUT_DIVIDE_MAX; o++)
+				if (freq_vco / o >= limits->output_freq_min &&
+				    freq_vco / o <= limits->output_freq_max)
+					vin->rates[n++] = freq_vco / o;
+		}
+	}
+
+	if (!data->solver_table_len) {
+		fprintf(stderr, "input %u Hz: no VCO frequency within limits\n",
+			clk_freq);
+		return -EINVAL;
+	}
+
+	/* incremental solver starts from VCO in the middle of the range */
+	if (!logiclk_pll_vco_mult_div(data,
+				      (limits->vco_freq_min +
+				       limits->vco_freq_max) / 2,
+				      &data->input.clkfbout_mult,
+				      &data->input.divclk_divide))
+		return -EINVAL;
+
+	span = limits->output_freq_max - limits->output_freq_min;
+	for (i = 0; i < rates_num; i++)
+		vin->rates[n++] = limits->output_freq_min +
+				  ((rates_num > 1) ?
+				   ((span * i) / (rates_num - 1)) : 0);
+
+	qsort(vin->rates, n, sizeof(u64), verify_cmp);
+	vin->rates_num = 0;
+	for (i = 0; i < n; i++)
+		if (!vin->rates_num ||
+		    (vin->rates[i] != vin->rates[vin->rates_num - 1]))
+			vin->rates[vin->rates_num++] = vin->rates[i];
+
+	return 0;
+}
+
+static void verify_usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [-f 7series|ultrascale] [-i input_hz[,input_hz...]]\n"
+		"       [-n rates] [-a] [-F] [-b budget] [-j threads] [-v]\n"
+		"  -f  device family limits, default 7series\n"
+		"  -i  input frequencies, default common board inputs\n"
+		"  -n  evenly spaced output frequencies, default %u\n"
+		"  -a  add every output frequency achievable with integer\n"
+		"      output divider\n"
+		"  -F  verify fractional output divider search too\n"
+		"  -b  solver iterations budget, default unlimited\n"
+		"  -j  threads, default online CPUs\n"
+		"  -v  report every mismatch and configuration difference\n",
+		name, VERIFY_RATES_DEFAULT);
+}
+
+int main(int argc, char **argv)
+{
+	const struct logiclk_family *family = &logiclk_family_7series;
+	u32 inputs[VERIFY_INPUTS_MAX];
+	unsigned int inputs_num = 0, rates_num = VERIFY_RATES_DEFAULT;
+	long threads = sysconf(_SC_NPROCESSORS_ONLN);
+	bool achievable = false;
+	pthread_t *tid;
+	char *tok, *end;
+	u64 failed;
+	long t;
+	int i, opt;
+
+	while ((opt = getopt(argc, argv, "f:i:n:aFb:j:vh")) != -1) {
+		switch (opt) {
+		case 'f':
+			if (!strcmp(optarg, "7series")) {
+				family = &logiclk_family_7series;
+			} else if (!strcmp(optarg, "ultrascale")) {
+				family = &logiclk_family_ultrascale;
+			} else {
+				verify_usage(argv[0]);
+				return 2;
+			}
+			break;
+		case 'i':
+			for (tok = strtok(optarg, ","); tok;
+			     tok = strtok(NULL, ",")) {
+				if (inputs_num == VERIFY_INPUTS_MAX) {
+					verify_usage(argv[0]);
+					return 2;
+				}
+				inputs[inputs_num++] = strtoul(tok, &end, 0);
+				if (*end) {
+					verify_usage(argv[0]);
+					return 2;
+				}
+			}
+			break;
+		case 'n':
+			rates_num = strtoul(optarg, NULL, 0);
+			break;
+		case 'a':
+			achievable = true;
+			break;
+		case 'F':
+			verify_frac = true;
+			break;
+		case 'b':
+			verify_budget = strtoul(optarg, NULL, 0);
+			break;
+		case 'j':
+			threads = strtol(optarg, NULL, 0);
+			break;
+		case 'v':
+			verify_verbose = true;
+			break;
+		default:
+			verify_usage(argv[0]);
+			return 2;
+		}
+	}
+
+	if (!inputs_num) {
+		inputs_num = ARRAY_SIZE(verify_inputs_default);
+		memcpy(inputs, verify_inputs_default,
+		       sizeof(verify_inputs_default));
+	}
+	if (threads < 1)
+		threads = 1;
+
+	for (i = 0; i < inputs_num; i++) {
+		if ((inputs[i] < family->limits.input_freq_min) ||
+		    (inputs[i] > family->limits.input_freq_max)) {
+			fprintf(stderr, "input %u Hz out of range\n",
+				inputs[i]);
+			return 2;
+		}
+		if (verify_input_init(&verify_input[verify_inputs], family,
+				      inputs[i], rates_num, achievable))
+			return 2;
+		verify_cases += verify_input[verify_inputs++].rates_num;
+	}
+
+	printf("%u inputs, %llu output frequencies, %ld threads%s\n",
+	       verify_inputs, verify_cases, threads,
+	       verify_frac ? ", fractional" : "");
+
+	tid = calloc(threads, sizeof(*tid));
+	if (!tid)
+		return 2;
+	for (t = 0; t < threads; t++)
+		if (pthread_create(&tid[t], NULL, verify_thread, NULL)) {
+			fprintf(stderr, "failed create thread\n");
+			return 2;
+		}
+	for (t = 0; t < threads; t++)
+		pthread_join(tid[t], NULL);
+
+	printf("%-12s %10s %8s %8s %8s %8s %10s %10s\n", "solver", "cases",
+	       "worse", "differ", "spent", "gap ppm", "avg iter", "max iter");
+	for (i = 0; i < ARRAY_SIZE(logiclk_solvers); i++) {
+		struct verify_stats *stats = &verify_total.stats[i];
+
+		printf("%-12s %10llu %8llu %8llu %8llu %8llu %10llu %10u\n",
+		       logiclk_solvers[i].name, stats->cases, stats->worse,
+		       stats->differ, stats->spent, stats->gap_max,
+		       stats->cases ? (stats->iterations / stats->cases) : 0,
+		       stats->iterations_max);
+	}
+	printf("vco_err mismatches %llu, reference mismatches %llu\n",
+	       verify_total.vco_err, verify_total.reference);
+
+	failed = verify_total.vco_err + verify_total.reference;
+	for (i = 0; i < ARRAY_SIZE(logiclk_solvers); i++)
+		failed += verify_total.stats[i].worse;
+
+	return failed ? 1 : 0;
+}